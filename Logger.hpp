@@ -1,13 +1,374 @@
 #pragma once
 
-#include <string>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// messages above this level are compiled out (0 FATAL, 1 ERROR, 2 WARNING)
+#ifndef LOGGER_LEVEL
+#define LOGGER_LEVEL 2
+#endif
 
+/*
+ * Asynchronous logger, one per thread. `log()` copies the format string
+ * pointer and its arguments into a slot of the thread's lock-free ring
+ * and returns; a background writer formats the messages and writes them
+ * to std::cout. Nothing is allocated nor formatted on the logging
+ * thread, except for the ring on its first message.
+ *
+ * Formats are string literals with a "{}" per argument. Integers,
+ * characters, floats and strings are supported, strings are copied and
+ * cut to the slot size. A full ring drops messages, and a format logged
+ * more than `rate_limit` times in a second is suppressed until the next
+ * one, both are counted in the output. Suppressed messages are counted
+ * with the next message of their format, or on `flush()` as the format
+ * itself followed by the count.
+ */
 class Logger {
 public:
-  enum class Level { ERROR, FATAL, WARNING };
+  enum class Level { FATAL, ERROR, WARNING };
+
+  ~Logger() {
+    if (ring) {
+      flush();
+      writer().remove(ring.get());
+    }
+  }
+
+  // runtime filter, on top of LOGGER_LEVEL
+  void set_level(Level max) { level = max; }
+
+  // messages per second and format, 0 for no limit
+  void set_rate_limit(uint32_t limit) { rate_limit = limit; }
+
+  // only string literals bind to `format`, the writer reads it later
+  template <Level message_level, size_t N, typename... Args>
+  void log(const char (&format)[N], const Args &...args) {
+    if constexpr ((int)message_level <= LOGGER_LEVEL) {
+      if (message_level > level)
+        return;
+
+      uint32_t suppressed = 0;
+      if (limited(format, suppressed))
+        return;
+
+      if (!ring)
+        start();
+
+      Slot *slot = ring->claim();
+      if (!slot)
+        return;
+
+      slot->format = format;
+      slot->suppressed = suppressed;
+      slot->size = 0;
+      slot->count_only = false;
+      (encode(*slot, args), ...);
+
+      ring->publish();
+    }
+  }
+
+  // write everything logged so far, by every thread
+  void flush() {
+    report_suppressed();
+    writer().drain();
+  }
+
+private:
+  enum class Tag : uint8_t { Signed, Unsigned, Char, Float, String };
+
+  struct Slot {
+    const char *format;
+    uint32_t suppressed; // previous messages of `format` rate limited
+    uint16_t size;
+    bool count_only; // just the suppressed count, there's no message
+    uint8_t payload[256 - 16];
+  };
+
+  // single producer (the logging thread), single consumer (the writer)
+  struct Ring {
+    static constexpr size_t capacity = 256;
+
+    std::unique_ptr<Slot[]> slots{new Slot[capacity]};
+    std::atomic<size_t> head{0}, tail{0};
+    std::atomic<uint64_t> dropped{0};
+
+    Slot *claim() {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == capacity) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      return &slots[h % capacity];
+    }
+
+    void publish() {
+      head.store(head.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+    }
+  };
+
+  /*
+   * Drains the rings of every thread every few milliseconds, or right
+   * away on `flush()`. The mutex only guards the ring list and the
+   * output, the logging threads never take it once registered.
+   */
+  class Writer {
+  public:
+    ~Writer() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      wake.notify_one();
+
+      if (thread.joinable())
+        thread.join();
+      drain();
+    }
+
+    void add(Ring *ring) {
+      std::lock_guard<std::mutex> lock(mutex);
+      rings.push_back(ring);
+
+      if (!thread.joinable())
+        thread = std::thread([this] { run(); });
+    }
+
+    void remove(Ring *ring) {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (size_t i = 0; i < rings.size(); ++i)
+        if (rings[i] == ring)
+          rings.erase(rings.begin() + i);
+    }
+
+    void drain() {
+      std::lock_guard<std::mutex> lock(mutex);
+      drain_locked();
+    }
+
+  private:
+    void run() {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      while (!stop) {
+        wake.wait_for(lock, std::chrono::milliseconds(5));
+        drain_locked();
+      }
+    }
+
+    void drain_locked() {
+      for (Ring *ring : rings) {
+        size_t t = ring->tail.load(std::memory_order_relaxed);
+        size_t h = ring->head.load(std::memory_order_acquire);
+
+        for (; t != h; ++t)
+          format(ring->slots[t % Ring::capacity]);
+        ring->tail.store(t, std::memory_order_release);
+
+        if (uint64_t dropped = ring->dropped.exchange(0))
+          buffer += std::to_string(dropped) + " messages dropped\n";
+      }
+
+      if (buffer.empty())
+        return;
+
+      std::cout.write(buffer.data(), buffer.size());
+      std::cout.flush();
+      buffer.clear();
+    }
+
+    void format(const Slot &slot) {
+      const uint8_t *arg = slot.payload;
+      const uint8_t *end = slot.payload + slot.size;
+
+      for (const char *p = slot.format; *p; ++p) {
+        if (p[0] != '{' || p[1] != '}' || arg == end || slot.count_only) {
+          buffer += *p;
+          continue;
+        }
+
+        p++;
+        arg = format_arg(arg);
+      }
+
+      if (slot.suppressed)
+        buffer += " (" + std::to_string(slot.suppressed) + " suppressed)";
+      buffer += '\n';
+    }
 
-  void log(Level level, std::string msg) {
-    std::cout << msg << '\n';
+    const uint8_t *format_arg(const uint8_t *arg) {
+      Tag tag = (Tag)*arg++;
+
+      if (tag == Tag::String) {
+        uint16_t length;
+        std::memcpy(&length, arg, sizeof(length));
+        buffer.append((const char *)arg + sizeof(length), length);
+        return arg + sizeof(length) + length;
+      }
+
+      if (tag == Tag::Float) {
+        long double value;
+        std::memcpy(&value, arg, sizeof(value));
+
+        char text[64];
+        std::snprintf(text, sizeof(text), "%Lg", value);
+        buffer += text;
+        return arg + sizeof(value);
+      }
+
+      uint64_t value;
+      std::memcpy(&value, arg, sizeof(value));
+
+      // clang-format off
+      switch (tag) {
+        case Tag::Signed:   buffer += std::to_string((int64_t)value); break;
+        case Tag::Unsigned: buffer += std::to_string(value);          break;
+        default:            buffer += (char)value;                    break;
+      }
+      // clang-format on
+
+      return arg + sizeof(value);
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread thread;
+    std::vector<Ring *> rings;
+    std::string buffer;
+    bool stop = false;
+  };
+
+  static Writer &writer() {
+    static Writer instance;
+    return instance;
+  }
+
+  void start() {
+    ring.reset(new Ring);
+    writer().add(ring.get());
+  }
+
+  // per format, counts in the current second
+  struct Rate {
+    const char *format = nullptr;
+    int64_t second = 0;
+    uint32_t count = 0;
+    uint32_t suppressed = 0;
+  };
+
+  bool limited(const char *format, uint32_t &suppressed) {
+    if (rate_limit == 0)
+      return false;
+
+    int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+
+    // a collision restarts the count of the other format, after
+    // reporting what it suppressed
+    Rate &rate = rates[((uintptr_t)format >> 3) % rates.size()];
+    if (rate.format != format && rate.suppressed)
+      report(rate);
+
+    if (rate.format != format || rate.second != second) {
+      suppressed = (rate.format == format) ? rate.suppressed : 0;
+      rate = {format, second, 0, 0};
+    }
+
+    if (++rate.count <= rate_limit)
+      return false;
+
+    rate.suppressed++;
+    return true;
+  }
+
+  // the counts of the formats still suppressed, which no message carries
+  void report_suppressed() {
+    for (Rate &rate : rates)
+      if (rate.suppressed)
+        report(rate);
   }
+
+  void report(Rate &rate) {
+    if (!ring)
+      start();
+
+    Slot *slot = ring->claim();
+    if (!slot)
+      return;
+
+    slot->format = rate.format;
+    slot->suppressed = rate.suppressed;
+    slot->size = 0;
+    slot->count_only = true;
+    ring->publish();
+
+    rate.suppressed = 0;
+  }
+
+  static void put(Slot &slot, Tag tag, const void *data, size_t size) {
+    if (slot.size + 1 + size > sizeof(slot.payload))
+      return;
+
+    slot.payload[slot.size] = (uint8_t)tag;
+    std::memcpy(slot.payload + slot.size + 1, data, size);
+    slot.size += 1 + size;
+  }
+
+  static void encode(Slot &slot, std::string_view str) {
+    size_t room = sizeof(slot.payload) - slot.size;
+    if (room < 1 + sizeof(uint16_t))
+      return;
+
+    uint16_t length = std::min(str.length(), room - 1 - sizeof(uint16_t));
+    uint8_t *p = slot.payload + slot.size;
+
+    *p = (uint8_t)Tag::String;
+    std::memcpy(p + 1, &length, sizeof(length));
+    std::memcpy(p + 1 + sizeof(length), str.data(), length);
+    slot.size += 1 + sizeof(length) + length;
+  }
+
+  static void encode(Slot &slot, const char *str) {
+    encode(slot, std::string_view(str));
+  }
+
+  static void encode(Slot &slot, const std::string &str) {
+    encode(slot, std::string_view(str));
+  }
+
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+  static void encode(Slot &slot, T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+      long double wide = value;
+      put(slot, Tag::Float, &wide, sizeof(wide));
+    } else {
+      Tag tag = std::is_same<T, char>::value ? Tag::Char
+                : std::is_signed<T>::value   ? Tag::Signed
+                                             : Tag::Unsigned;
+      uint64_t bits = (uint64_t)value;
+      put(slot, tag, &bits, sizeof(bits));
+    }
+  }
+
+  std::unique_ptr<Ring> ring;
+  Level level = Level::WARNING;
+  uint32_t rate_limit = 100;
+  std::array<Rate, 64> rates{};
 };
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Read-only memory mapping of a whole file, views into it stay valid
+ * as long as the object lives.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("can't open file: " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+      close(fd);
+      throw std::runtime_error("can't stat file: " + path);
+    }
+
+    size = st.st_size;
+
+    // mmap() rejects empty mappings
+    if (size != 0) {
+      data = (const char *)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("can't map file: " + path);
+      }
+
+      madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (size != 0)
+      munmap((void *)data, size);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  std::string_view view() const { return {data, size}; }
+
+private:
+  const char *data = nullptr;
+  size_t size = 0;
+};
@@ -0,0 +1,428 @@
+/*
+ * Microbenchmarks for every parser and validator, run with `make bench`.
+ *
+ * Each benchmark runs a function over a generated corpus (digits per
+ * literal, separator density, error rate) until it took long enough,
+ * then reports ns/literal, cycles/byte and allocations per call. The
+ * table goes to stderr and the JSON results to stdout, or to the file
+ * given as first argument.
+ */
+
+#define NPARSER_NO_MAIN
+#include "main.cpp"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// every allocation goes through these, so they can be counted; per
+// thread, the Logger's writer allocates while the benchmarks run
+static thread_local size_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+enum class CorpusKind { Decimal, Hex, Octal, Binary, DecimalFloat, HexFloat };
+
+struct CorpusSpec {
+  CorpusKind kind;
+  bool prefix;       // "0x", "0o", "0b" in front of the digits
+  size_t length;     // digits per literal
+  double separators; // chance of a '\'' after each digit
+  double errors;     // fraction of literals with an invalid character
+};
+
+struct Corpus {
+  CorpusSpec spec;
+  std::string name;
+  std::vector<std::string> literals;
+  size_t bytes = 0;
+};
+
+struct Result {
+  std::string function;
+  std::string corpus;
+  size_t calls;
+  double ns_per_literal;
+  double cycles_per_byte;
+  double allocations_per_call;
+};
+
+Corpus make_corpus(const CorpusSpec &spec, size_t count, uint64_t seed) {
+  static const char *kinds[] = {"dec", "hex", "oct", "bin", "decf", "hexf"};
+  static const char *prefixes[] = {"", "0x", "0o", "0b", "", "0x"};
+  static const char *digit_sets[] = {"0123456789", "0123456789abcdefABCDEF",
+                                     "01234567",   "01",
+                                     "0123456789", "0123456789abcdef"};
+
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> chance(0, 1);
+
+  size_t kind = (size_t)spec.kind;
+  std::string digits = digit_sets[kind];
+  bool floating = (spec.kind == CorpusKind::DecimalFloat ||
+                   spec.kind == CorpusKind::HexFloat);
+
+  Corpus corpus;
+  corpus.spec = spec;
+
+  char name[96];
+  std::snprintf(name, sizeof(name), "%s%s/len=%zu/sep=%.2f/err=%.2f",
+                kinds[kind], spec.prefix ? "+prefix" : "", spec.length,
+                spec.separators, spec.errors);
+  corpus.name = name;
+
+  for (size_t i = 0; i < count; ++i) {
+    std::string literal = spec.prefix ? prefixes[kind] : "";
+    size_t start = literal.length();
+
+    // a float has the '.' in the middle of its digits
+    size_t dot = floating ? 1 + rng() % std::max<size_t>(spec.length - 1, 1)
+                          : spec.length;
+
+    for (size_t d = 0; d < spec.length; ++d) {
+      if (d == dot)
+        literal += '.';
+
+      literal += digits[rng() % digits.length()];
+
+      if (d + 1 < spec.length && d + 1 != dot && chance(rng) < spec.separators)
+        literal += '\'';
+    }
+
+    if (floating) {
+      literal += (spec.kind == CorpusKind::HexFloat) ? 'p' : 'e';
+      if (rng() % 2)
+        literal += '-';
+      literal += std::to_string(rng() % 30);
+    }
+
+    if (chance(rng) < spec.errors) {
+      size_t at = start + rng() % (literal.length() - start);
+      literal[at] = "#zg "[rng() % 4];
+    }
+
+    corpus.bytes += literal.length();
+    corpus.literals.push_back(std::move(literal));
+  }
+
+  return corpus;
+}
+
+// `count` literals drawn from `distinct` timestamps like "1697040123.125"
+Corpus make_repeated_corpus(size_t count, size_t distinct, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+
+  std::vector<std::string> timestamps;
+  for (size_t i = 0; i < distinct; ++i) {
+    char literal[32];
+    std::snprintf(literal, sizeof(literal), "16970%05u.%03u",
+                  (unsigned)(rng() % 100000), (unsigned)(rng() % 1000));
+    timestamps.push_back(literal);
+  }
+
+  Corpus corpus;
+  corpus.spec = {CorpusKind::DecimalFloat, false, 13, 0, 0};
+  corpus.name = "timestamps/distinct=" + std::to_string(distinct);
+
+  for (size_t i = 0; i < count; ++i) {
+    corpus.literals.push_back(timestamps[rng() % distinct]);
+    corpus.bytes += corpus.literals.back().length();
+  }
+
+  return corpus;
+}
+
+// keeps the results alive so the calls aren't optimised away
+static volatile uint64_t sink;
+
+// `round()` goes over the whole corpus once
+template <typename Round>
+Result measure(const char *function, const Corpus &corpus, Round round) {
+  using Clock = std::chrono::steady_clock;
+  const std::chrono::duration<double> min_time(0.05);
+
+  // warm up caches and branch predictors
+  round();
+
+  size_t rounds = 0;
+  size_t allocated = allocations;
+  uint64_t start_cycles = cycles();
+  Clock::time_point start = Clock::now();
+  std::chrono::duration<double> elapsed{};
+
+  while (elapsed < min_time) {
+    round();
+
+    rounds++;
+    elapsed = Clock::now() - start;
+  }
+
+  uint64_t spent_cycles = cycles() - start_cycles;
+  allocated = allocations - allocated;
+
+  size_t calls = rounds * corpus.literals.size();
+  return {function,
+          corpus.name,
+          calls,
+          elapsed.count() * 1e9 / calls,
+          (double)spent_cycles / (rounds * corpus.bytes),
+          (double)allocated / calls};
+}
+
+template <typename Function>
+Result run(const char *function, const Corpus &corpus, Function f) {
+  return measure(function, corpus, [&] {
+    for (const std::string &literal : corpus.literals)
+      sink = sink + (uint64_t)f(literal);
+  });
+}
+
+// one call for the whole corpus, `streams` literals interleaved
+template <size_t streams>
+Result run_validate_batch(const char *function, const Corpus &corpus,
+                          Grammar grammar) {
+  std::vector<std::string_view> literals(corpus.literals.begin(),
+                                         corpus.literals.end());
+  std::unique_ptr<bool[]> valid(new bool[literals.size()]);
+
+  return measure(function, corpus, [&] {
+    validate_batch<streams>(grammar, literals.data(), literals.size(),
+                            valid.get());
+    sink = sink + valid[0];
+  });
+}
+
+// the corpus packed in one buffer, either ',' separated or cut at
+// `offsets`, one call for all of it
+Result run_integer_batch(const char *function, const Corpus &corpus,
+                         bool delimited) {
+  std::string buffer;
+  std::vector<size_t> offsets{0};
+  for (const std::string &literal : corpus.literals) {
+    buffer += literal;
+    if (delimited)
+      buffer += ',';
+    offsets.push_back(buffer.length());
+  }
+
+  size_t count = corpus.literals.size();
+  std::unique_ptr<uint64_t[]> values(new uint64_t[count]);
+  std::unique_ptr<uint8_t[]> valid(new uint8_t[(count + 7) / 8]);
+
+  return measure(function, corpus, [&] {
+    if (delimited)
+      parse_integer_batch(buffer.data(), buffer.length(), ',', values.get(),
+                          valid.get(), count);
+    else
+      parse_integer_batch(buffer.data(), offsets.data(), count, values.get(),
+                          valid.get());
+    sink = sink + values[0] + valid[0];
+  });
+}
+
+// the corpus as one space separated stream, fed in `chunk` byte reads
+template <typename Parser>
+Result run_push(const char *function, const Corpus &corpus, size_t chunk) {
+  std::string stream;
+  for (const std::string &literal : corpus.literals)
+    stream += literal + ' ';
+
+  uint64_t total = 0;
+  Parser parser([&](size_t, std::string_view, const auto &result) {
+    total += (uint64_t)result.value;
+  });
+
+  return measure(function, corpus, [&] {
+    for (size_t i = 0; i < stream.length(); i += chunk)
+      parser.feed(stream.data() + i, std::min(chunk, stream.length() - i));
+    parser.finish();
+    sink = sink + total;
+  });
+}
+
+// the throwing parsers count an invalid literal as 0
+template <typename Function> auto guard(Function f) {
+  return [f](const std::string &literal) -> uint64_t {
+    try {
+      return (uint64_t)f(literal);
+    } catch (const std::exception &) {
+      return 0;
+    }
+  };
+}
+
+void write_json(std::ostream &out, const std::vector<Result> &results) {
+  out << "[\n";
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    out << "  {\"function\": \"" << r.function << "\", \"corpus\": \""
+        << r.corpus << "\", \"calls\": " << r.calls
+        << ", \"ns_per_literal\": " << r.ns_per_literal
+        << ", \"cycles_per_byte\": " << r.cycles_per_byte
+        << ", \"allocations_per_call\": " << r.allocations_per_call << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+
+  out << "]\n";
+}
+
+int main(int argc, char *argv[]) {
+  const size_t count = 4096;
+  std::vector<Result> results;
+
+  // the `Logger` parse_float() writes its errors to std::cout
+  std::streambuf *cout_buffer = std::cout.rdbuf(nullptr);
+
+  for (size_t length : {8, 16}) {
+    for (double separators : {0.0, 0.25}) {
+      for (double errors : {0.0, 0.05}) {
+        auto corpus = [&](CorpusKind kind, bool prefix) {
+          return make_corpus({kind, prefix, length, separators, errors}, count,
+                             results.size() + 1);
+        };
+
+        Corpus dec = corpus(CorpusKind::Decimal, false);
+        Corpus hex = corpus(CorpusKind::Hex, false);
+        Corpus oct = corpus(CorpusKind::Octal, false);
+        Corpus bin = corpus(CorpusKind::Binary, false);
+        Corpus hex_prefixed = corpus(CorpusKind::Hex, true);
+        Corpus oct_prefixed = corpus(CorpusKind::Octal, true);
+        Corpus bin_prefixed = corpus(CorpusKind::Binary, true);
+        Corpus dec_float = corpus(CorpusKind::DecimalFloat, false);
+        Corpus hex_float = corpus(CorpusKind::HexFloat, true);
+
+        auto kernel = [](uint64_t (*parse)(size_t, const std::string &,
+                                           size_t)) {
+          return guard([parse](const std::string &literal) {
+            return parse(0, literal, literal.length());
+          });
+        };
+
+        results.push_back(run("parse_dec", dec, kernel(parse_dec)));
+        results.push_back(run("parse_hex", hex, kernel(parse_hex)));
+        results.push_back(run("parse_oct", oct, kernel(parse_oct)));
+        results.push_back(run("parse_bin", bin, kernel(parse_bin)));
+
+        auto integer = guard(
+            [](const std::string &literal) { return parse_integer(literal); });
+        results.push_back(run("parse_integer", dec, integer));
+        results.push_back(run("parse_integer", hex_prefixed, integer));
+        results.push_back(
+            run_integer_batch("parse_integer_batch(,)", dec, true));
+        results.push_back(
+            run_integer_batch("parse_integer_batch(offsets)", dec, false));
+
+        for (const Corpus *floats : {&dec_float, &hex_float}) {
+          results.push_back(run("parse_floating_point", *floats,
+                                guard([](const std::string &literal) {
+                                  return parse_floating_point(literal);
+                                })));
+
+          results.push_back(
+              run("float_literal<double>", *floats,
+                  [](const std::string &literal) {
+                    return float_literal<double>(literal).value;
+                  }));
+
+          results.push_back(run("parse_float", *floats,
+                                guard([](const std::string &literal) {
+                                  return parse_float(literal);
+                                })));
+
+          results.push_back(run("parse_float(log)", *floats,
+                                guard([](const std::string &literal) {
+                                  std::string log;
+                                  return parse_float(literal, log);
+                                })));
+        }
+
+        results.push_back(run_push<IntegerPushParser>("IntegerPushParser",
+                                                      dec, 4096));
+        results.push_back(run_push<FloatingPointPushParser>(
+            "FloatingPointPushParser", dec_float, 4096));
+
+        auto valid = [](const std::string &literal) {
+          return valid_integer(literal);
+        };
+        results.push_back(run("valid_integer", dec, valid));
+        results.push_back(run("valid_integer", hex_prefixed, valid));
+
+        results.push_back(run("validate_dec", dec_float, validate_dec));
+        results.push_back(run("validate_hex", hex_float, validate_hex));
+        results.push_back(run("validate_oct", oct_prefixed, validate_oct));
+        results.push_back(run("validate_bin", bin_prefixed, validate_bin));
+
+        results.push_back(run_validate_batch<1>("validate_batch<1>", dec_float,
+                                                Grammar::Dec));
+        results.push_back(run_validate_batch<4>("validate_batch<4>", dec_float,
+                                                Grammar::Dec));
+        results.push_back(run_validate_batch<8>("validate_batch<8>", dec_float,
+                                                Grammar::Dec));
+
+        logger.flush();
+      }
+    }
+  }
+
+  // a few distinct literals over and over, what LiteralCache is for
+  Corpus repeated = make_repeated_corpus(count, 64, results.size() + 1);
+  FloatingPointCache cache;
+
+  results.push_back(
+      run("parse_floating_point", repeated, [](const std::string &literal) {
+        const char *first = literal.data();
+        return parse_floating_point(first, first + literal.length()).value;
+      }));
+
+  results.push_back(
+      run("FloatingPointCache", repeated, [&](const std::string &literal) {
+        const char *first = literal.data();
+        return cache(first, first + literal.length()).value;
+      }));
+
+  std::cout.rdbuf(cout_buffer);
+  std::cout.clear();
+
+  std::fprintf(stderr, "%-28s %-34s %10s %10s %10s\n", "function", "corpus",
+               "ns/lit", "cyc/byte", "alloc/call");
+  for (const Result &r : results)
+    std::fprintf(stderr, "%-28s %-34s %10.2f %10.2f %10.3f\n",
+                 r.function.c_str(), r.corpus.c_str(), r.ns_per_literal,
+                 r.cycles_per_byte, r.allocations_per_call);
+
+  std::fprintf(stderr, "FloatingPointCache %s: %llu hits, %llu misses\n",
+               repeated.name.c_str(), (unsigned long long)cache.hits(),
+               (unsigned long long)cache.misses());
+
+  if (argc > 1) {
+    std::ofstream out(argv[1]);
+    write_json(out, results);
+  } else {
+    write_json(std::cout, results);
+  }
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Locale independent character classification shared by every parser
+ * and validator. Unlike <cctype> it's constexpr, inlines to a single
+ * load and is the same for all the code paths.
+ *
+ * Each character has a set of class flags and its value as a base 36
+ * digit (case insensitive, `NotADigit` otherwise), so checking a digit
+ * of any base is `char_value(c) < base`.
+ */
+struct CharClass {
+  static constexpr uint8_t Digit = 1 << 0;       // 0-9
+  static constexpr uint8_t XDigit = 1 << 1;      // 0-9, a-f, A-F
+  static constexpr uint8_t Separator = 1 << 2;   // '
+  static constexpr uint8_t Dot = 1 << 3;         // .
+  static constexpr uint8_t DecExponent = 1 << 4; // e, E
+  static constexpr uint8_t HexExponent = 1 << 5; // p, P
+  static constexpr uint8_t Sign = 1 << 6;        // +, -
+  static constexpr uint8_t Identifier = 1 << 7;  // a-z, A-Z, 0-9, _
+
+  static constexpr uint8_t NotADigit = 0xFF;
+};
+
+struct CharTable {
+  std::array<uint8_t, 256> classes{};
+  std::array<uint8_t, 256> values{};
+};
+
+constexpr CharTable make_char_table() {
+  CharTable table;
+
+  for (int c = 0; c < 256; ++c)
+    table.values[c] = CharClass::NotADigit;
+
+  for (int c = '0'; c <= '9'; ++c) {
+    table.classes[c] = CharClass::Digit | CharClass::XDigit;
+    table.values[c] = c - '0';
+  }
+
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table.values[c] = table.values[c - 'a' + 'A'] = c - 'a' + 10;
+
+    if (c <= 'f')
+      table.classes[c] = table.classes[c - 'a' + 'A'] = CharClass::XDigit;
+  }
+
+  for (int c = 0; c < 256; ++c)
+    if (table.values[c] != CharClass::NotADigit || c == '_')
+      table.classes[c] |= CharClass::Identifier;
+
+  table.classes['\''] |= CharClass::Separator;
+  table.classes['.'] |= CharClass::Dot;
+  table.classes['e'] |= CharClass::DecExponent;
+  table.classes['E'] |= CharClass::DecExponent;
+  table.classes['p'] |= CharClass::HexExponent;
+  table.classes['P'] |= CharClass::HexExponent;
+  table.classes['+'] |= CharClass::Sign;
+  table.classes['-'] |= CharClass::Sign;
+
+  return table;
+}
+
+constexpr CharTable char_table = make_char_table();
+
+constexpr uint8_t char_class(unsigned char c) { return char_table.classes[c]; }
+
+constexpr uint8_t char_value(unsigned char c) { return char_table.values[c]; }
+
+constexpr bool is_digit(unsigned char c) {
+  return char_class(c) & CharClass::Digit;
+}
+
+constexpr bool is_xdigit(unsigned char c) {
+  return char_class(c) & CharClass::XDigit;
+}
+
+constexpr bool is_identifier(unsigned char c) {
+  return char_class(c) & CharClass::Identifier;
+}
@@ -0,0 +1,979 @@
+/*
+ * Consistency checks, run with `make check`.
+ *
+ * Each check runs an optimised or parallel path and its plain
+ * counterpart over generated inputs and reports where they differ. The
+ * exit status is the number of failed checks.
+ */
+
+#define NPARSER_NO_MAIN
+#include "main.cpp"
+
+#include <cstdio>
+#include <random>
+#include <sstream>
+
+struct Check {
+  const char *name;
+  size_t cases = 0;
+  size_t failures = 0;
+
+  // prints the first few failures
+  template <typename... Args> void fail(const char *format, Args... args) {
+    if (failures++ < 5) {
+      std::fprintf(stderr, "%s: ", name);
+      std::fprintf(stderr, format, args...);
+      std::fprintf(stderr, "\n");
+    }
+  }
+};
+
+// C like source, with comments and strings spanning lines
+std::string make_source(std::mt19937_64 &rng, size_t tokens) {
+  static const char *pieces[] = {
+      "0x1F",  "1.5e3", "42",       "0b101",          "7'000",   "0.25",
+      ".5",    "017",   "0o17",     "0x1.8p-3",       "x1",      "abc",
+      "'5'",   "\"6\"", "/* 12 */", "/*\n0x1234\n*/", "// 99\n", "\"3 \\\n4\"",
+      "\n",    "\n\n",  " ",        ";",              "+",
+  };
+
+  std::string source;
+  for (size_t i = 0; i < tokens; ++i) {
+    source += pieces[rng() % (sizeof(pieces) / sizeof(*pieces))];
+    source += " \n"[rng() % 2];
+  }
+
+  return source;
+}
+
+bool same(const Literal &a, const Literal &b) {
+  return a.offset == b.offset && a.kind == b.kind &&
+         a.floating == b.floating && a.text == b.text &&
+         a.integer == b.integer &&
+         (a.real == b.real || (a.real != a.real && b.real != b.real));
+}
+
+Check check_scan_parallel() {
+  Check check{"scan_literals_parallel"};
+  std::mt19937_64 rng(1);
+
+  for (size_t i = 0; i < 2000; ++i) {
+    std::string source = make_source(rng, rng() % 200);
+
+    std::vector<Literal> expected;
+    scan_literals(source, [&](const Literal &literal) {
+      expected.push_back(literal);
+    });
+
+    for (size_t chunk_size : {1, 7, 64, 4096}) {
+      unsigned threads = 1 + rng() % 4;
+      std::vector<Literal> literals =
+          scan_literals_parallel(source, threads, chunk_size);
+      check.cases++;
+
+      bool equal = literals.size() == expected.size();
+      for (size_t j = 0; equal && j < literals.size(); ++j)
+        equal = same(literals[j], expected[j]);
+
+      if (!equal)
+        check.fail("%zu literals instead of %zu, chunks of %zu on %u "
+                   "threads, source:\n%s",
+                   literals.size(), expected.size(), chunk_size, threads,
+                   source.c_str());
+    }
+  }
+
+  return check;
+}
+
+// a kernel variant, only checked when the CPU supports it
+template <typename Kernel> struct Variant {
+  const char *name;
+  bool supported;
+  Kernel kernel;
+};
+
+// `length` characters of `alphabet`, each one being `rare` 1 time in 16
+std::string make_chars(std::mt19937_64 &rng, size_t length,
+                       const char *alphabet, const char *rare) {
+  std::string chars;
+  for (size_t i = 0; i < length; ++i) {
+    const char *from = (rng() % 16) ? alphabet : rare;
+    chars += from[rng() % std::strlen(from)];
+  }
+  return chars;
+}
+
+Check check_strip_kernels() {
+  Check check{"strip_separators"};
+  std::mt19937_64 rng(2);
+
+  std::vector<Variant<StripKernel>> variants;
+#if defined(__x86_64__) || defined(__i386__)
+  variants.push_back({"strip_separators_bmi2",
+                      __builtin_cpu_supports("bmi2") != 0,
+                      strip_separators_bmi2});
+  variants.push_back({"strip_separators_vbmi2",
+                      __builtin_cpu_supports("avx512vbmi2") != 0,
+                      strip_separators_vbmi2});
+#endif
+
+  for (const Variant<StripKernel> &variant : variants) {
+    if (!variant.supported) {
+      std::fprintf(stderr, "%s: skipped, not supported\n", variant.name);
+      continue;
+    }
+
+    for (size_t i = 0; i < 200000; ++i) {
+      size_t window = rng() % 65;
+      std::string chars = make_chars(rng, window, "0123456789abcdef", "'");
+
+      char expected[72], digits[72];
+      std::memset(expected, 0x55, sizeof(expected));
+      std::memset(digits, 0x55, sizeof(digits));
+
+      uint64_t separators = strip_separators(chars.data(), window, expected);
+      uint64_t result = variant.kernel(chars.data(), window, digits);
+      check.cases++;
+
+      if (result != separators ||
+          (separators && std::memcmp(digits, expected, 64) != 0))
+        check.fail("%s differs on \"%s\"", variant.name, chars.c_str());
+    }
+  }
+
+  return check;
+}
+
+/*
+ * The leading digits of `[first, last)` in `base`: a digit kernel
+ * either returns 0 or their count with their value, when they fit and
+ * don't stop at a separator.
+ */
+bool kernel_may_take(const char *first, const char *last, unsigned base,
+                     size_t &length, uint64_t &value) {
+  length = 0;
+  value = 0;
+
+  bool fits = true;
+  for (; first + length < last && char_value(first[length]) < base;
+       ++length) {
+    unsigned digit = char_value(first[length]);
+    fits &= (value <= (UINT64_MAX - digit) / base);
+    value = value * base + digit;
+  }
+
+  return length != 0 && fits &&
+         (first + length == last || first[length] != '\'');
+}
+
+Check check_digit_kernels() {
+  Check check{"digit kernels"};
+  std::mt19937_64 rng(3);
+
+  struct Digits {
+    Variant<VectorKernel> variant;
+    unsigned base;
+    const char *alphabet;
+  };
+
+  std::vector<Digits> variants;
+#if defined(__x86_64__) || defined(__i386__)
+  variants.push_back({{"parse_hex_ssse3", __builtin_cpu_supports("ssse3") != 0,
+                       parse_hex_ssse3},
+                      16,
+                      "0123456789abcdefABCDEF"});
+  variants.push_back({{"parse_hex_avx2", __builtin_cpu_supports("avx2") != 0,
+                       parse_hex_avx2},
+                      16,
+                      "0123456789abcdefABCDEF"});
+  variants.push_back({{"parse_bin_sse2", __builtin_cpu_supports("sse2") != 0,
+                       parse_bin_sse2},
+                      2,
+                      "01"});
+  variants.push_back({{"parse_bin_avx2", __builtin_cpu_supports("avx2") != 0,
+                       parse_bin_avx2},
+                      2,
+                      "01"});
+  variants.push_back(
+      {{"parse_bin_avx512", __builtin_cpu_supports("avx512bw") != 0,
+        parse_bin_avx512},
+       2,
+       "01"});
+#endif
+
+  for (const Digits &digits : variants) {
+    const Variant<VectorKernel> &variant = digits.variant;
+    if (!variant.supported) {
+      std::fprintf(stderr, "%s: skipped, not supported\n", variant.name);
+      continue;
+    }
+
+    for (size_t i = 0; i < 200000; ++i) {
+      // runs of leading zeros, so long literals can still fit
+      std::string chars(rng() % 4 ? 0 : rng() % 24, '0');
+      chars += make_chars(rng, rng() % 80, digits.alphabet, "'g.2 ");
+
+      const char *first = chars.data();
+      const char *last = first + chars.length();
+
+      size_t length;
+      uint64_t value, result = 0;
+      bool may_take = kernel_may_take(first, last, digits.base, length, value);
+
+      size_t used = variant.kernel(first, last, result);
+      check.cases++;
+
+      if (used && (!may_take || used != length || result != value))
+        check.fail("%s took %zu characters of \"%s\" as %llu",
+                   variant.name, used, chars.c_str(),
+                   (unsigned long long)result);
+    }
+  }
+
+  return check;
+}
+
+Check check_fields_kernels() {
+  Check check{"fields kernels"};
+  std::mt19937_64 rng(4);
+
+  std::vector<Variant<FieldsKernel>> variants;
+#if defined(__x86_64__) || defined(__i386__)
+  variants.push_back({"parse_fields_avx2", __builtin_cpu_supports("avx2") != 0,
+                      parse_fields_avx2});
+  variants.push_back({"parse_fields_avx512",
+                      __builtin_cpu_supports("avx512bw") != 0,
+                      parse_fields_avx512});
+#endif
+
+  for (const Variant<FieldsKernel> &variant : variants) {
+    if (!variant.supported) {
+      std::fprintf(stderr, "%s: skipped, not supported\n", variant.name);
+      continue;
+    }
+
+    for (size_t i = 0; i < 200000; ++i) {
+      // mostly short fields, so the kernel takes a good part of them
+      std::string buffer;
+      size_t fields = field_lanes - 2 + rng() % 6;
+      for (size_t f = 0; f < fields; ++f) {
+        size_t length = (rng() % 8) ? 1 + rng() % 8 : rng() % 12;
+        buffer += make_chars(rng, length, "0123456789", "'x-");
+        buffer += ',';
+      }
+      if (rng() % 2)
+        buffer.pop_back();
+
+      const char *first = buffer.data();
+      const char *last = first + buffer.length();
+
+      uint64_t values[field_lanes];
+      size_t used = variant.kernel(first, last, ',', values);
+      check.cases++;
+
+      if (!used)
+        continue;
+
+      // the fields it took must all be 1 to 8 digits
+      const char *p = first;
+      bool same = true;
+      for (size_t f = 0; same && f < field_lanes; ++f) {
+        const char *end = (const char *)std::memchr(p, ',', last - p);
+        uint64_t value = 0;
+
+        same = end && end - p >= 1 && end - p <= 8 &&
+               std::all_of(p, end, [](char c) { return is_digit(c); }) &&
+               parse_integer_field(p, end, value) && value == values[f];
+        p = end ? end + 1 : last;
+      }
+
+      if (!same || (size_t)(p - first) != used)
+        check.fail("%s took %zu characters of \"%s\"", variant.name, used,
+                   buffer.c_str());
+    }
+  }
+
+  return check;
+}
+
+// the delimited parse_integer_batch against the plain field loop
+Check check_integer_batch() {
+  Check check{"parse_integer_batch"};
+  std::mt19937_64 rng(9);
+
+  const uint64_t unset = 0x5A5A5A5A5A5A5A5A;
+
+  for (size_t i = 0; i < 100000; ++i) {
+    // runs of short decimals the kernel takes, and a few it doesn't
+    std::string buffer;
+    size_t fields = rng() % 80;
+    bool clean = rng() % 2;
+    for (size_t f = 0; f < fields; ++f) {
+      size_t length = (clean || rng() % 8) ? 1 + rng() % 8 : rng() % 24;
+      buffer += make_chars(rng, length, "0123456789",
+                           clean ? "0123456789" : "'x-,");
+      buffer += ';';
+    }
+    if (rng() % 2 && !buffer.empty())
+      buffer.pop_back();
+
+    // often fewer than a group of fields
+    size_t capacity = (rng() % 2) ? rng() % (field_lanes + 2) : rng() % 96;
+
+    std::vector<uint64_t> values(capacity + 1, unset), expected = values;
+    std::vector<uint8_t> valid(capacity / 8 + 2, 0x5A), expected_valid = valid;
+
+    const char *first = buffer.data();
+    size_t count = parse_integer_batch(first, buffer.length(), ';',
+                                       values.data(), valid.data(), capacity);
+    size_t expected_count = parse_batch<uint64_t, parse_integer_field>(
+        first, buffer.length(), ';', expected.data(), expected_valid.data(),
+        capacity);
+
+    // bits past the last field aren't specified
+    bool same = count == expected_count && values == expected;
+    for (size_t f = 0; same && f < count; ++f)
+      same = ((valid[f / 8] ^ expected_valid[f / 8]) >> (f & 7) & 1) == 0;
+    for (size_t b = (count + 7) / 8; same && b < valid.size(); ++b)
+      same = valid[b] == expected_valid[b];
+
+    check.cases++;
+    if (!same)
+      check.fail("%zu fields of \"%s\" with capacity %zu, expected %zu",
+                 count, buffer.c_str(), capacity, expected_count);
+  }
+
+  return check;
+}
+
+template <typename T>
+bool same(const ParseResult<T> &a, const ParseResult<T> &b) {
+  bool values =
+      (a.value == b.value) || (a.value != a.value && b.value != b.value);
+  return values && a.error == b.error && a.offset == b.offset &&
+         a.kind == b.kind;
+}
+
+// a small table, so the literals keep evicting each other
+template <typename T, ParseResult<T> (*parse)(const char *, const char *)>
+void check_cache(Check &check, const char *name, std::mt19937_64 &rng) {
+  LiteralCache<T, parse, 64> cache;
+
+  // valid and invalid ones, some too long to be cached
+  std::vector<std::string> literals;
+  for (size_t i = 0; i < 2000; ++i) {
+    std::string literal = (rng() % 4) ? "" : "0x";
+    literal += make_chars(rng, 1 + rng() % 30, "0123456789", "'.eEp-xz");
+    literals.push_back(literal);
+  }
+
+  for (size_t i = 0; i < 200000; ++i) {
+    const std::string &literal = literals[rng() % literals.size()];
+    const char *first = literal.data();
+    const char *last = first + literal.length();
+
+    check.cases++;
+    if (!same(cache(first, last), parse(first, last)))
+      check.fail("%s differs on \"%s\"", name, literal.c_str());
+  }
+
+  if (cache.hits() == 0 || cache.misses() <= literals.size())
+    check.fail("%s: %llu hits and %llu misses, expected both with evictions",
+               name, (unsigned long long)cache.hits(),
+               (unsigned long long)cache.misses());
+}
+
+Check check_literal_cache() {
+  Check check{"LiteralCache"};
+  std::mt19937_64 rng(5);
+
+  check_cache<long double, parse_floating_point>(check, "FloatingPointCache",
+                                                 rng);
+  check_cache<int64_t, parse_integer>(check, "LiteralCache<int64_t>", rng);
+
+  return check;
+}
+
+/*
+ * The hand-written validators the DFA replaced, as the reference for
+ * it.
+ */
+namespace reference {
+
+// <integer>[.<fraction>][e/E[sign]<exponent>]
+bool validate_dec(std::string_view str) {
+  enum class Section { Integer, Fraction, Exponent };
+  size_t section_size = 0;
+
+  if (str.empty() || !is_digit(str[0]))
+    return false;
+  else
+    section_size++;
+
+  Section section = Section::Integer;
+  for (size_t i = 1; i < str.length(); i++) {
+    unsigned char c = str[i];
+
+    if (c == '\'') {
+      if (str[i - 1] == '\'')
+        return false;
+
+      continue;
+    }
+
+    if (is_digit(c)) {
+      section_size++;
+      continue;
+    }
+
+    if (c == '.') {
+      if (section != Section::Integer || section_size == 0)
+        return false;
+
+      section = Section::Fraction;
+      section_size = 0;
+      continue;
+    }
+
+    if (c == 'e' || c == 'E') {
+      if (section == Section::Exponent || section_size == 0)
+        return false;
+
+      if (i + 1 >= str.length())
+        return false;
+
+      if (str[i + 1] == '+' || str[i + 1] == '-')
+        i++;
+
+      section = Section::Exponent;
+      section_size = 0;
+      continue;
+    }
+
+    return false;
+  }
+
+  return section_size != 0;
+}
+
+// 0x<integer>[.<fraction>][p/P[sign]<exponent>]
+bool validate_hex(std::string_view str) {
+  enum class Section { Integer, Fraction, Exponent };
+  size_t section_size = 0;
+
+  if (!starts_with(str, "0x") && !starts_with(str, "0X"))
+    return false;
+
+  // just prefix
+  if (str.length() - 2 == 0)
+    return false;
+
+  Section section = Section::Integer;
+  for (size_t i = 2; i < str.length(); i++) {
+    unsigned char c = str[i];
+
+    if (c == '\'') {
+      if (str[i - 1] == '\'')
+        return false;
+
+      continue;
+    }
+
+    if (section == Section::Exponent ? is_digit(c) : is_xdigit(c)) {
+      section_size++;
+      continue;
+    }
+
+    if (c == '.') {
+      if (section != Section::Integer || section_size == 0)
+        return false;
+
+      section = Section::Fraction;
+      section_size = 0;
+      continue;
+    }
+
+    if (c == 'p' || c == 'P') {
+      if (section == Section::Exponent || section_size == 0)
+        return false;
+
+      if (i + 1 >= str.length())
+        return false;
+
+      if (str[i + 1] == '+' || str[i + 1] == '-')
+        i++;
+
+      section = Section::Exponent;
+      section_size = 0;
+      continue;
+    }
+
+    return false;
+  }
+
+  return section_size != 0;
+}
+
+// 0o or 0b then the digits of `base`
+bool validate_integer(std::string_view str, char prefix, unsigned base) {
+  if (str.length() < 2 || str[0] != '0' || (str[1] | 0x20) != prefix)
+    return false;
+
+  // just prefix
+  if (str.length() - 2 == 0)
+    return false;
+
+  for (size_t i = 2; i < str.length(); i++) {
+    unsigned char c = str[i];
+
+    if (c == '\'') {
+      if (str[i - 1] == '\'')
+        return false;
+
+      continue;
+    }
+
+    if (c < '0' || c >= '0' + base)
+      return false;
+  }
+
+  return true;
+}
+
+bool validate(Grammar grammar, std::string_view str) {
+  // clang-format off
+  switch (grammar) {
+    case Grammar::Dec: return validate_dec(str);
+    case Grammar::Hex: return validate_hex(str);
+    case Grammar::Oct: return validate_integer(str, 'o', 8);
+    case Grammar::Bin: return validate_integer(str, 'b', 2);
+  }
+  // clang-format on
+
+  return false;
+}
+
+} // namespace reference
+
+// literals and near misses of every grammar
+std::string make_literal(std::mt19937_64 &rng) {
+  static const char *prefixes[] = {"", "", "0x", "0X", "0o", "0B", "0"};
+  std::string literal = prefixes[rng() % 7];
+
+  literal += make_chars(rng, rng() % 24, "0123456789abcdefABCDEF.'",
+                        "eEpP+-'.xoOb_ \\x80");
+  return literal;
+}
+
+Check check_validators() {
+  Check check{"validators"};
+  std::mt19937_64 rng(6);
+
+  const Grammar grammars[] = {Grammar::Dec, Grammar::Hex, Grammar::Oct,
+                              Grammar::Bin};
+
+  for (size_t i = 0; i < 500000; ++i) {
+    std::string literal = make_literal(rng);
+
+    for (Grammar grammar : grammars) {
+      check.cases++;
+      if (validate(grammar, literal) != reference::validate(grammar, literal))
+        check.fail("grammar %d differs on \"%s\"", (int)grammar,
+                   literal.c_str());
+    }
+  }
+
+  return check;
+}
+
+template <size_t streams>
+void check_batch(Check &check, Grammar grammar,
+                 const std::vector<std::string_view> &literals) {
+  std::unique_ptr<bool[]> valid(new bool[literals.size() + 1]);
+  validate_batch<streams>(grammar, literals.data(), literals.size(),
+                          valid.get());
+
+  for (size_t i = 0; i < literals.size(); ++i) {
+    check.cases++;
+    if (valid[i] != validate(grammar, literals[i]))
+      check.fail("validate_batch<%zu> differs on literal %zu of %zu, \"%.*s\"",
+                 streams, i, literals.size(), (int)literals[i].length(),
+                 literals[i].data());
+  }
+}
+
+Check check_validate_batch() {
+  Check check{"validate_batch"};
+  std::mt19937_64 rng(7);
+
+  const Grammar grammars[] = {Grammar::Dec, Grammar::Hex, Grammar::Oct,
+                              Grammar::Bin};
+
+  for (size_t i = 0; i < 20000; ++i) {
+    // fewer literals than streams too, all of uneven lengths
+    std::vector<std::string> column(rng() % 20);
+    for (std::string &literal : column)
+      literal = make_literal(rng);
+
+    std::vector<std::string_view> literals(column.begin(), column.end());
+    Grammar grammar = grammars[rng() % 4];
+
+    check_batch<3>(check, grammar, literals);
+    check_batch<4>(check, grammar, literals);
+    check_batch<8>(check, grammar, literals);
+  }
+
+  return check;
+}
+
+struct Pushed {
+  size_t offset;
+  std::string text;
+  ParseResult<long double> result;
+
+  bool operator==(const Pushed &other) const {
+    return offset == other.offset && text == other.text &&
+           same(result, other.result);
+  }
+};
+
+// `stream` fed in reads of 0 to `chunk` - 1 bytes, or whole if 0
+std::vector<Pushed> push(const std::string &stream, size_t chunk,
+                         std::mt19937_64 &rng) {
+  std::vector<Pushed> numbers;
+  FloatingPointPushParser parser(
+      [&](size_t offset, std::string_view text,
+          const ParseResult<long double> &result) {
+        numbers.push_back({offset, std::string(text), result});
+      });
+
+  for (size_t i = 0; i < stream.length();) {
+    size_t length = chunk ? rng() % chunk : stream.length();
+    length = std::min(length, stream.length() - i);
+
+    parser.feed(stream.data() + i, length);
+    i += length;
+  }
+
+  parser.finish();
+  return numbers;
+}
+
+Check check_push_parser() {
+  Check check{"PushParser"};
+  std::mt19937_64 rng(8);
+
+  static const char *pieces[] = {
+      "0x1'FFFF.8p-3", "1.5e+10", "12'345", "abc12",   ".5", "1.",
+      "3e-2",          "x.5",     "1''2",   "1'",      "42", "9e",
+      "1.2.3",         "0x1p+4",  "_7",     "1e9999",  "0b101",
+  };
+  static const char *separators[] = {" ", ",", "\n", "; ", ".", "'", "+"};
+
+  for (size_t i = 0; i < 20000; ++i) {
+    std::string stream;
+    for (size_t n = rng() % 12; n > 0; --n) {
+      stream += pieces[rng() % (sizeof(pieces) / sizeof(*pieces))];
+      stream += separators[rng() % (sizeof(separators) / sizeof(*separators))];
+    }
+
+    // ending in the middle of a number too
+    if (rng() % 2 && !stream.empty())
+      stream.pop_back();
+
+    std::vector<Pushed> whole = push(stream, 0, rng);
+    std::vector<Pushed> chunked = push(stream, 4, rng);
+    check.cases++;
+
+    bool equal = whole.size() == chunked.size();
+    for (size_t j = 0; equal && j < whole.size(); ++j)
+      equal = whole[j] == chunked[j] &&
+              stream.compare(whole[j].offset, whole[j].text.length(),
+                             whole[j].text) == 0;
+
+    if (!equal)
+      check.fail("%zu numbers fed whole, %zu in chunks, stream \"%s\"",
+                 whole.size(), chunked.size(), stream.c_str());
+  }
+
+  return check;
+}
+
+// decimal digits of `n` * 2^`k`, exactly, as "<digits>e<exponent>"
+std::string exact_decimal(unsigned __int128 n, int k) {
+  const uint32_t base = 1000000000;
+
+  // base 10^9, least significant first
+  std::vector<uint32_t> limbs;
+  for (; n; n /= base)
+    limbs.push_back((uint32_t)(n % base));
+
+  auto multiply = [&](uint32_t m) {
+    uint64_t carry = 0;
+    for (uint32_t &limb : limbs) {
+      uint64_t product = (uint64_t)limb * m + carry;
+      limb = product % base;
+      carry = product / base;
+    }
+    for (; carry; carry /= base)
+      limbs.push_back(carry % base);
+  };
+
+  // 2^-k is 5^k * 10^-k
+  int exponent = 0;
+  for (; k > 0; k -= std::min(k, 29))
+    multiply(1u << std::min(k, 29));
+  for (; k < 0; k += std::min(-k, 13)) {
+    uint32_t five = 1;
+    for (int i = 0; i < std::min(-k, 13); ++i)
+      five *= 5;
+
+    multiply(five);
+    exponent -= std::min(-k, 13);
+  }
+
+  std::string digits = std::to_string(limbs.back());
+  for (size_t i = limbs.size() - 1; i-- > 0;) {
+    char limb[16];
+    std::snprintf(limb, sizeof(limb), "%09u", limbs[i]);
+    digits += limb;
+  }
+
+  return digits + "e" + std::to_string(exponent);
+}
+
+// the decimal just below `literal` ("<digits>e<exponent>")
+std::string below(const std::string &literal) {
+  size_t e = literal.find('e');
+  std::string digits = literal.substr(0, e);
+  int exponent = std::atoi(literal.c_str() + e + 1);
+
+  // digits * 10 - 1
+  size_t i = digits.length();
+  while (digits[--i] == '0')
+    digits[i] = '9';
+  digits[i]--;
+
+  return digits + "9e" + std::to_string(exponent - 1);
+}
+
+// the decimal just above `literal`
+std::string above(const std::string &literal) {
+  size_t e = literal.find('e');
+  int exponent = std::atoi(literal.c_str() + e + 1);
+  return literal.substr(0, e) + "1e" + std::to_string(exponent - 1);
+}
+
+template <typename T> T strto(const char *str);
+template <> float strto<float>(const char *str) {
+  return std::strtof(str, nullptr);
+}
+template <> double strto<double>(const char *str) {
+  return std::strtod(str, nullptr);
+}
+template <> long double strto<long double>(const char *str) {
+  return std::strtold(str, nullptr);
+}
+
+// `literal` through float_literal<T>, against strto*() of it without
+// separators
+template <typename T>
+void check_float(Check &check, const char *type, const std::string &literal) {
+  std::string plain;
+  for (char c : literal)
+    if (c != '\'')
+      plain += c;
+
+  ParseResult<T> result = float_literal<T>(literal);
+  T expected = strto<T>(plain.c_str());
+  check.cases++;
+
+  bool same = result ? result.value == expected
+                     : result.error == ParseError::OutOfRange &&
+                           expected == std::numeric_limits<T>::infinity();
+  if (!same)
+    check.fail("float_literal<%s> differs from strto* on \"%s\"", type,
+               literal.c_str());
+}
+
+/*
+ * A random finite value of T, its binary exponent `spread` wide around
+ * 0 or anywhere in the range when `spread` is 0, subnormals included.
+ */
+template <typename T> T random_float(std::mt19937_64 &rng, int spread) {
+  using F = FloatFormat<T>;
+
+  int low = spread ? -spread : F::emin - F::digits + 1;
+  int high = spread ? spread : F::emax;
+  int exponent = low + (int)(rng() % (high - low + 1));
+
+  uint64_t mantissa = (rng() >> (64 - F::digits)) | 1;
+  return std::ldexp((T)mantissa, exponent - F::digits + 1);
+}
+
+template <typename T> void check_floats(Check &check, const char *type) {
+  using F = FloatFormat<T>;
+  std::mt19937_64 rng(9);
+
+  // halfway between neighbours, and just below and above it
+  for (size_t i = 0; i < 3000; ++i) {
+    T x = random_float<T>(rng, (i % 10) ? 300 : 0);
+
+    int exponent;
+    std::frexp(x, &exponent);
+
+    // x is m * 2^q, q is fixed for subnormals
+    int q = std::max(exponent, F::emin + 1) - F::digits;
+    uint64_t m = (uint64_t)std::ldexp(x, -q);
+
+    std::string halfway = exact_decimal((unsigned __int128)2 * m + 1, q - 1);
+    check_float<T>(check, type, halfway);
+    check_float<T>(check, type, below(halfway));
+    check_float<T>(check, type, above(halfway));
+  }
+
+  for (size_t i = 0; i < 100000; ++i) {
+    // a shortest-ish decimal of a random value, then random digits
+    char literal[96];
+    T x = random_float<T>(rng, (i % 4) ? 64 : 0);
+    std::snprintf(literal, sizeof(literal), "%.*Le", (int)(rng() % 25),
+                  (long double)x);
+    check_float<T>(check, type, literal);
+
+    std::string digits =
+        make_chars(rng, 1 + rng() % 30, "0123456789", "'") + "1";
+    size_t dot = rng() % digits.length();
+    if (digits[dot] != '\'' && dot > 0 && digits[dot - 1] != '\'')
+      digits.insert(dot, ".");
+
+    int range = F::max10 - F::min10;
+    int exponent = F::min10 - 10 + (int)(rng() % (range + 20));
+    check_float<T>(check, type, digits + "e" + std::to_string(exponent));
+
+    // hex floats, integer and fraction digits then a binary exponent
+    std::string hex = "0x" + make_chars(rng, 1 + rng() % 20,
+                                        "0123456789abcdefABCDEF", "'0") +
+                      "1";
+    if (rng() % 2)
+      hex += "." + make_chars(rng, 1 + rng() % 10, "0123456789abcdef", "0");
+    hex += "p" + std::to_string((int)(rng() % (2 * F::emax + 200)) -
+                                F::emax - 100);
+    check_float<T>(check, type, hex);
+  }
+}
+
+Check check_float_conversion() {
+  Check check{"float conversion"};
+
+  check_floats<float>(check, "float");
+  check_floats<double>(check, "double");
+  check_floats<long double>(check, "long double");
+
+  return check;
+}
+
+// lines the Logger writes while `log()` runs, it's flushed at the end
+template <typename Log> std::vector<std::string> logged(Log log) {
+  std::ostringstream out;
+  std::streambuf *previous = std::cout.rdbuf(out.rdbuf());
+
+  {
+    Logger logger;
+    log(logger);
+  }
+
+  std::cout.rdbuf(previous);
+
+  std::vector<std::string> lines;
+  std::istringstream in(out.str());
+  for (std::string line; std::getline(in, line);)
+    lines.push_back(line);
+  return lines;
+}
+
+Check check_logger() {
+  Check check{"Logger"};
+
+  // a burst past the limit, the rest is counted on flush()
+  std::vector<std::string> lines = logged([](Logger &logger) {
+    logger.set_rate_limit(100);
+    for (int i = 0; i < 250; ++i)
+      logger.log<Logger::Level::ERROR>("burst {}", i);
+    logger.flush();
+  });
+
+  // 100 a second, the burst may just cross into the next one
+  size_t messages = 0, suppressed = 0;
+  for (const std::string &line : lines) {
+    unsigned long count;
+    if (std::sscanf(line.c_str(), "burst {} (%lu suppressed)", &count) == 1)
+      suppressed += count;
+    else if (line.compare(0, 6, "burst ") == 0)
+      messages++;
+  }
+
+  check.cases++;
+  if (messages < 100 || messages > 200 || messages + suppressed != 250)
+    check.fail("rate limit: %zu messages and %zu suppressed of 250",
+               messages, suppressed);
+
+  // far more than the ring holds, the rest is counted as dropped
+  lines = logged([](Logger &logger) {
+    logger.set_rate_limit(0);
+    for (int i = 0; i < 100000; ++i)
+      logger.log<Logger::Level::ERROR>("flood {}", i);
+  });
+
+  size_t dropped = 0;
+  messages = 0;
+  for (const std::string &line : lines) {
+    unsigned long count;
+    if (std::sscanf(line.c_str(), "%lu messages dropped", &count) == 1)
+      dropped += count;
+    else if (line.compare(0, 6, "flood ") == 0)
+      messages++;
+  }
+
+  check.cases++;
+  if (dropped == 0 || messages + dropped != 100000)
+    check.fail("ring: %zu messages and %zu dropped of 100000", messages,
+               dropped);
+
+  // the level filter
+  lines = logged([](Logger &logger) {
+    logger.set_level(Logger::Level::FATAL);
+    logger.log<Logger::Level::ERROR>("filtered");
+    logger.log<Logger::Level::FATAL>("fatal {}", 1);
+  });
+
+  check.cases++;
+  if (lines != std::vector<std::string>{"fatal 1"})
+    check.fail("set_level(FATAL) logged %zu lines", lines.size());
+
+  return check;
+}
+
+int main() {
+  std::vector<Check> checks;
+  checks.push_back(check_scan_parallel());
+  checks.push_back(check_strip_kernels());
+  checks.push_back(check_digit_kernels());
+  checks.push_back(check_fields_kernels());
+  checks.push_back(check_integer_batch());
+  checks.push_back(check_literal_cache());
+  checks.push_back(check_validators());
+  checks.push_back(check_validate_batch());
+  checks.push_back(check_push_parser());
+  checks.push_back(check_float_conversion());
+  checks.push_back(check_logger());
+
+  int failed = 0;
+  for (const Check &check : checks) {
+    std::fprintf(stderr, "%-24s %8zu cases %8zu failures\n", check.name,
+                 check.cases, check.failures);
+    failed += (check.failures != 0);
+  }
+
+  return failed;
+}
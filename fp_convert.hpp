@@ -0,0 +1,606 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "power_tables.hpp"
+
+/*
+ * Correctly rounded decimal/hex -> binary floating point conversion.
+ *
+ * The fast path is Eisel-Lemire: the (at most 19) leading digits are
+ * multiplied by a 128-bit approximation of 10^q, which is enough to
+ * round correctly except for values extremely close to a halfway
+ * point. Those (and subnormal results) go through an exact big
+ * integer comparison, so the result always matches strtod/strtold.
+ *
+ * Hex digits map straight to bits, they're gathered into a 64-bit
+ * significand and rounded once.
+ *
+ * Everything is constexpr, so literals can be converted at compile
+ * time. Targets are limited to 64 significant bits: float, double and
+ * an x87 extended long double, not a quad precision one.
+ */
+
+/*
+ * Binary layout of a floating point target, `digits` counts the
+ * integer bit, `emin`/`emax` are the unbiased exponents of the
+ * smallest/biggest normal values.
+ */
+template <typename T> struct FloatFormat {
+  static constexpr int digits = std::numeric_limits<T>::digits;
+  static_assert(digits <= 64, "only float, double and x87 long double");
+  static constexpr int emin = std::numeric_limits<T>::min_exponent - 1;
+  static constexpr int emax = std::numeric_limits<T>::max_exponent - 1;
+
+  // x87 extended precision stores the integer bit explicitly
+  static constexpr bool explicit_integer_bit = (digits == 64);
+
+  // a rounded up mantissa equal to this carried out (wraps at 64 digits)
+  static constexpr uint64_t carry = ((uint64_t)1 << (digits - 1)) << 1;
+
+  // halfway points have at most ~112/767/11515 significant digits,
+  // the slow path folds anything past this into a sticky bit
+  static constexpr int max_digits =
+      (digits <= 24) ? 120 : (digits <= 53) ? 800 : 11600;
+
+  // decimal exponents past which the result is always inf/0
+  static constexpr int max10 = std::numeric_limits<T>::max_exponent10;
+  static constexpr int min10 = (int)(((int64_t)(emin - digits) * 78913) >> 18);
+};
+
+/*
+ * Build `mantissa * 2^exponent`, the mantissa is already rounded to
+ * `digits` bits. Normal values have the top bit set, subnormals have
+ * `exponent == emin - digits + 1`.
+ */
+template <typename T>
+constexpr T compose_float(uint64_t mantissa, int64_t exponent) {
+  using F = FloatFormat<T>;
+
+  const uint64_t top_bit = (uint64_t)1 << (F::digits - 1);
+  uint64_t biased = 0;
+
+  if (mantissa & top_bit)
+    biased = exponent + (F::digits - 1) + F::emax;
+
+  if (biased >= (uint64_t)(2 * F::emax + 1))
+    return std::numeric_limits<T>::infinity();
+
+  T result = 0;
+
+  // no bit casts in constant evaluation: scaling by powers of two is
+  // exact since every intermediate value has the final's bits
+  if (__builtin_is_constant_evaluated()) {
+    result = (T)mantissa;
+
+    for (; exponent >= 32; exponent -= 32)
+      result *= (T)((uint64_t)1 << 32);
+    for (; exponent <= -32; exponent += 32)
+      result /= (T)((uint64_t)1 << 32);
+
+    return (exponent >= 0) ? result * (T)((uint64_t)1 << exponent)
+                           : result / (T)((uint64_t)1 << -exponent);
+  }
+
+  if constexpr (F::explicit_integer_bit) {
+    unsigned char bytes[sizeof(T)] = {};
+    uint16_t high = (uint16_t)biased;
+
+    std::memcpy(bytes, &mantissa, sizeof(mantissa));
+    std::memcpy(bytes + sizeof(mantissa), &high, sizeof(high));
+    std::memcpy(&result, bytes, sizeof(T));
+  } else if constexpr (sizeof(T) == sizeof(uint32_t)) {
+    uint32_t bits = ((uint32_t)biased << (F::digits - 1)) |
+                    ((uint32_t)mantissa & (uint32_t)(top_bit - 1));
+    std::memcpy(&result, &bits, sizeof(bits));
+  } else {
+    uint64_t bits = (biased << (F::digits - 1)) | (mantissa & (top_bit - 1));
+    std::memcpy(&result, &bits, sizeof(bits));
+  }
+
+  return result;
+}
+
+/*
+ * Significant digits of a decimal literal, the value is
+ * `mantissa * 10^exponent` (plus something, when `truncated`).
+ */
+struct DecimalDigits {
+  uint64_t mantissa = 0; // first 19 significant digits
+  int64_t exponent = 0;
+  size_t count = 0; // significant digits seen
+  bool truncated = false;
+
+  constexpr void append(unsigned digit, bool fraction) {
+    // leading zeros
+    if (count == 0 && digit == 0) {
+      if (fraction)
+        exponent--;
+      return;
+    }
+
+    if (count < 19) {
+      mantissa = (mantissa * 10) + digit;
+      if (fraction)
+        exponent--;
+    } else {
+      truncated |= (digit != 0);
+      if (!fraction)
+        exponent++;
+    }
+
+    count++;
+  }
+};
+
+/*
+ * Significant digits of a hex literal, the value is
+ * `(mantissa * 16 + next) * 2^(exponent - 4)`, plus something when
+ * `truncated`. 16 digits fill the mantissa, `next` keeps the round bit
+ * for targets with a 64-bit mantissa.
+ */
+struct HexDigits {
+  uint64_t mantissa = 0; // first 16 significant digits
+  int64_t exponent = 0;
+  size_t count = 0; // significant digits seen
+  unsigned next = 0;
+  bool truncated = false;
+
+  constexpr void append(unsigned digit, bool fraction) {
+    // leading zeros
+    if (count == 0 && digit == 0) {
+      if (fraction)
+        exponent -= 4;
+      return;
+    }
+
+    if (count < 16) {
+      mantissa = (mantissa << 4) | digit;
+      if (fraction)
+        exponent -= 4;
+    } else {
+      if (count == 16)
+        next = digit;
+      else
+        truncated |= (digit != 0);
+
+      if (!fraction)
+        exponent += 4;
+    }
+
+    count++;
+  }
+};
+
+/*
+ * Fixed capacity unsigned big integer, little-endian 64-bit limbs.
+ * Only what the slow path needs, callers keep the values in range.
+ */
+struct BigUInt {
+  static constexpr size_t capacity = 640; // 40960 bits
+
+  uint64_t limbs[capacity] = {};
+  size_t size = 0;
+
+  constexpr bool is_zero() const { return size == 0; }
+
+  constexpr void normalize() {
+    while (size > 0 && limbs[size - 1] == 0)
+      size--;
+  }
+
+  constexpr void mul_add_small(uint64_t m, uint64_t a) {
+    for (size_t i = 0; i < size; ++i) {
+      unsigned __int128 p = (unsigned __int128)limbs[i] * m + a;
+      limbs[i] = (uint64_t)p;
+      a = (uint64_t)(p >> 64);
+    }
+
+    if (a != 0 && size < capacity)
+      limbs[size++] = a;
+  }
+
+  constexpr void mul_pow5(uint64_t n) {
+    const uint64_t pow5_27 = 7450580596923828125ULL; // 5^27
+
+    for (; n >= 27; n -= 27)
+      mul_add_small(pow5_27, 0);
+
+    uint64_t m = 1;
+    while (n--)
+      m *= 5;
+
+    mul_add_small(m, 0);
+  }
+
+  constexpr void shl(size_t bits) {
+    if (size == 0)
+      return;
+
+    size_t words = bits / 64, shift = bits % 64;
+    size_t new_size = size + words + 1;
+    if (new_size > capacity)
+      new_size = capacity;
+
+    for (size_t i = new_size; i-- > 0;) {
+      size_t from = i - words;
+      uint64_t hi = (i >= words && from < size) ? limbs[from] : 0;
+      uint64_t lo =
+          (shift && i > words && from - 1 < size) ? limbs[from - 1] : 0;
+      limbs[i] = shift ? (hi << shift) | (lo >> (64 - shift)) : hi;
+    }
+
+    size = new_size;
+    normalize();
+  }
+
+  constexpr void shr1() {
+    for (size_t i = 0; i < size; ++i) {
+      uint64_t next = (i + 1 < size) ? limbs[i + 1] : 0;
+      limbs[i] = (limbs[i] >> 1) | (next << 63);
+    }
+    normalize();
+  }
+
+  constexpr size_t bit_length() const {
+    if (size == 0)
+      return 0;
+    return size * 64 - __builtin_clzll(limbs[size - 1]);
+  }
+
+  constexpr bool bit(size_t i) const {
+    return (i / 64 < size) && ((limbs[i / 64] >> (i % 64)) & 1);
+  }
+
+  // any set bit in [0, end)
+  constexpr bool any_below(size_t end) const {
+    for (size_t i = 0; i < size && i * 64 < end; ++i) {
+      uint64_t limb = limbs[i];
+      if (end - i * 64 < 64)
+        limb &= ((uint64_t)1 << (end - i * 64)) - 1;
+      if (limb)
+        return true;
+    }
+    return false;
+  }
+
+  // up to 64 bits starting at `pos`
+  constexpr uint64_t bits_at(size_t pos, size_t count) const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < count; ++i)
+      result |= (uint64_t)bit(pos + i) << i;
+    return result;
+  }
+
+  constexpr int compare(const BigUInt &other) const {
+    if (size != other.size)
+      return size < other.size ? -1 : 1;
+
+    for (size_t i = size; i-- > 0;)
+      if (limbs[i] != other.limbs[i])
+        return limbs[i] < other.limbs[i] ? -1 : 1;
+
+    return 0;
+  }
+
+  // *this -= other, requires *this >= other
+  constexpr void sub(const BigUInt &other) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < size; ++i) {
+      uint64_t o = (i < other.size) ? other.limbs[i] : 0;
+      uint64_t d = limbs[i] - o - borrow;
+      borrow = (limbs[i] < o) || (limbs[i] - o < borrow);
+      limbs[i] = d;
+    }
+    normalize();
+  }
+};
+
+/*
+ * Round `n * 2^e2` (strictly more when `sticky`) to the nearest
+ * value of T, ties to even.
+ */
+template <typename T>
+constexpr T round_big(const BigUInt &n, int64_t e2, bool sticky) {
+  using F = FloatFormat<T>;
+
+  if (n.is_zero())
+    return 0;
+
+  int64_t length = n.bit_length();
+  int64_t msb_exponent = length - 1 + e2;
+  if (msb_exponent > F::emax)
+    return std::numeric_limits<T>::infinity();
+
+  // subnormal results keep less precision
+  int64_t precision = F::digits;
+  if (msb_exponent < F::emin)
+    precision -= F::emin - msb_exponent;
+
+  int64_t cut = length - precision;
+  if (cut <= 0)
+    return compose_float<T>(n.bits_at(0, length) << -cut, e2 + cut);
+
+  uint64_t mantissa = (precision > 0) ? n.bits_at(cut, precision) : 0;
+  bool round = n.bit(cut - 1);
+  bool rest = sticky || n.any_below(cut - 1);
+
+  int64_t exponent = e2 + cut;
+  if (round && (rest || (mantissa & 1)) && ++mantissa == F::carry) {
+    mantissa = (uint64_t)1 << (F::digits - 1);
+    exponent++;
+  }
+
+  return compose_float<T>(mantissa, exponent);
+}
+
+/*
+ * Round `m * 2^e2` (strictly more when `sticky`) to the nearest value
+ * of T, ties to even.
+ */
+template <typename T>
+constexpr T round_u128(unsigned __int128 m, int64_t e2, bool sticky) {
+  using F = FloatFormat<T>;
+
+  if (m == 0)
+    return 0;
+
+  uint64_t high = (uint64_t)(m >> 64);
+  int64_t length = high ? 128 - __builtin_clzll(high)
+                        : 64 - __builtin_clzll((uint64_t)m);
+
+  int64_t msb_exponent = length - 1 + e2;
+  if (msb_exponent > F::emax)
+    return std::numeric_limits<T>::infinity();
+
+  // subnormal results keep less precision, below half of the
+  // smallest one everything is 0
+  int64_t precision = F::digits;
+  if (msb_exponent < F::emin)
+    precision -= F::emin - msb_exponent;
+
+  if (precision < 0)
+    return 0;
+
+  int64_t cut = length - precision;
+  if (cut <= 0)
+    return compose_float<T>((uint64_t)m << -cut, e2 + cut);
+
+  uint64_t mantissa = (cut < 128) ? (uint64_t)(m >> cut) : 0;
+  bool round = (m >> (cut - 1)) & 1;
+  bool rest = sticky || (m & (((unsigned __int128)1 << (cut - 1)) - 1));
+
+  int64_t exponent = e2 + cut;
+  if (round && (rest || (mantissa & 1)) && ++mantissa == F::carry) {
+    mantissa = (uint64_t)1 << (F::digits - 1);
+    exponent++;
+  }
+
+  return compose_float<T>(mantissa, exponent);
+}
+
+/*
+ * Exact conversion of the digits in `[first, last)` (separators and
+ * a '.' are skipped) times 10^exponent.
+ */
+template <typename T>
+constexpr T decimal_slow_path(const char *first, const char *last,
+                              int64_t exponent) {
+  using F = FloatFormat<T>;
+
+  BigUInt digits;
+  size_t count = 0;
+  bool in_fraction = false;
+  bool sticky = false;
+
+  for (const char *p = first; p < last; ++p) {
+    if (*p == '\'')
+      continue;
+
+    if (*p == '.') {
+      in_fraction = true;
+      continue;
+    }
+
+    unsigned digit = *p - '0';
+    if (count == 0 && digit == 0) {
+      if (in_fraction)
+        exponent--;
+      continue;
+    }
+
+    if (count < F::max_digits) {
+      digits.mul_add_small(10, digit);
+      if (in_fraction)
+        exponent--;
+    } else {
+      sticky |= (digit != 0);
+      if (!in_fraction)
+        exponent++;
+    }
+
+    count++;
+  }
+
+  if (count == 0)
+    return 0;
+
+  // value is in [10^(exponent + kept - 1), 10^(exponent + kept))
+  int64_t kept = std::min<size_t>(count, F::max_digits);
+
+  if (exponent + kept - 1 > F::max10)
+    return std::numeric_limits<T>::infinity();
+
+  if (exponent + kept <= F::min10)
+    return 0;
+
+  if (exponent >= 0) {
+    // digits * 5^e * 2^e
+    digits.mul_pow5(exponent);
+    return round_big<T>(digits, exponent, sticky);
+  }
+
+  // digits / (5^k * 2^k): keep F::digits + 2 quotient bits or more
+  BigUInt divisor;
+  divisor.limbs[0] = 1;
+  divisor.size = 1;
+  divisor.mul_pow5(-exponent);
+
+  int64_t shift = (int64_t)(F::digits + 2) + (int64_t)divisor.bit_length() -
+                  (int64_t)digits.bit_length();
+
+  if (shift > 0)
+    digits.shl(shift);
+  else
+    divisor.shl(-shift);
+
+  const size_t quotient_bits = F::digits + 3;
+  divisor.shl(quotient_bits - 1);
+
+  BigUInt quotient;
+  quotient.size = 2;
+  quotient.limbs[0] = quotient.limbs[1] = 0;
+
+  for (size_t i = quotient_bits; i-- > 0;) {
+    if (digits.compare(divisor) >= 0) {
+      digits.sub(divisor);
+      quotient.limbs[i / 64] |= (uint64_t)1 << (i % 64);
+    }
+    divisor.shr1();
+  }
+  quotient.normalize();
+
+  return round_big<T>(quotient, exponent - shift, sticky || !digits.is_zero());
+}
+
+/*
+ * Eisel-Lemire fast path for `w * 10^q`, returns false when the
+ * 128-bit approximation of 10^q can't decide the rounding, or the
+ * result is subnormal.
+ */
+template <typename T>
+constexpr bool eisel_lemire(uint64_t w, int64_t q, T &out) {
+  using F = FloatFormat<T>;
+
+  if (w == 0) {
+    out = 0;
+    return true;
+  }
+
+  if (q < POW5_128_MIN_Q || q > POW5_128_MAX_Q)
+    return false;
+
+  int lz = __builtin_clzll(w);
+  w <<= lz;
+
+  const uint64_t *power = &pow5_128[2 * (q - POW5_128_MIN_Q)];
+
+  // 192-bit product p2:p1:p0
+  unsigned __int128 high = (unsigned __int128)w * power[0];
+  unsigned __int128 low = (unsigned __int128)w * power[1];
+  unsigned __int128 upper = high + (uint64_t)(low >> 64); // p2:p1
+  uint64_t p0 = (uint64_t)low;
+
+  // value ~= product * 2^e2
+  int64_t e2 = ((217706 * q) >> 16) - 127 - lz;
+  int msb = 190 + (int)(upper >> 127);
+
+  if (msb + e2 > F::emax) {
+    out = std::numeric_limits<T>::infinity();
+    return true;
+  }
+
+  if (msb + e2 < F::emin)
+    return false;
+
+  // bits below the mantissa: round bit at tail - 1
+  int tail = msb + 1 - F::digits;
+
+  uint64_t mantissa = (uint64_t)(upper >> (tail - 64));
+  bool round = (upper >> (tail - 65)) & 1;
+
+  unsigned __int128 rest_mask = ((unsigned __int128)1 << (tail - 65)) - 1;
+  unsigned __int128 rest_high = upper & rest_mask;
+
+  // 5^q is exact for q in [0, 55], otherwise the product is below the
+  // real value by less than 2^64
+  bool exact = (q >= 0 && q <= 55);
+  if (!exact && rest_high == rest_mask)
+    return false;
+
+  bool rest = (rest_high != 0) || (p0 != 0) || !exact;
+
+  int64_t exponent = e2 + tail;
+  if (round && (rest || (mantissa & 1)) && ++mantissa == F::carry) {
+    mantissa = (uint64_t)1 << (F::digits - 1);
+    exponent++;
+  }
+
+  out = compose_float<T>(mantissa, exponent);
+  return true;
+}
+
+/*
+ * Clinger's fast path for `w * 10^q`: when w and 10^|q| are both exact
+ * in T a single multiply or divide rounds correctly. Exponents past the
+ * table still qualify while `w * 10^(q - max_q)` stays exact. Needs T
+ * operations to round to T (no excess precision, FLT_EVAL_METHOD 0).
+ */
+template <typename T> constexpr bool clinger(uint64_t w, int64_t q, T &out) {
+  using F = FloatFormat<T>;
+  using P = ExactPowers10<T>;
+
+  if constexpr (FLT_EVAL_METHOD != 0 && !std::is_same<T, long double>::value)
+    return false;
+
+  const uint64_t exact = (F::digits >= 64) ? UINT64_MAX
+                                           : ((uint64_t)1 << F::digits);
+  if (w > exact || q < -P::max_q || q > P::max_q + 19)
+    return false;
+
+  for (; q > P::max_q; q--)
+    if (__builtin_mul_overflow(w, 10, &w) || w > exact)
+      return false;
+
+  out = (q < 0) ? (T)w / P::table[-q] : (T)w * P::table[q];
+  return true;
+}
+
+/*
+ * Correctly rounded value of the decimal digits in `[first, last)`
+ * times 10^exponent, `digits` holds the leading ones as collected by
+ * the caller.
+ */
+template <typename T>
+constexpr T decimal_to_float(const DecimalDigits &digits, const char *first,
+                             const char *last, int64_t exponent) {
+  int64_t q = digits.exponent + exponent;
+  T result = 0, upper = 0;
+
+  if (!digits.truncated && clinger<T>(digits.mantissa, q, result))
+    return result;
+
+  if (eisel_lemire<T>(digits.mantissa, q, result) &&
+      (!digits.truncated ||
+       (eisel_lemire<T>(digits.mantissa + 1, q, upper) && result == upper)))
+    return result;
+
+  return decimal_slow_path<T>(first, last, exponent);
+}
+
+/*
+ * Correctly rounded value of the hex digits gathered in `digits` times
+ * 2^exponent, hex literals need rounding only at the last bit so this
+ * is exact bit assembly with no slow path.
+ */
+template <typename T>
+constexpr T hex_to_float(const HexDigits &digits, int64_t exponent) {
+  unsigned __int128 m = (unsigned __int128)digits.mantissa << 4;
+  m |= digits.next;
+
+  return round_u128<T>(m, digits.exponent + exponent - 4, digits.truncated);
+}
@@ -1,351 +1,1811 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "Logger.hpp"
+#include "charclass.hpp"
+#include "MappedFile.hpp"
+#include "fp_convert.hpp"
+#include "simd.hpp"
+#include "validator.hpp"
 
-Logger logger;
+// per thread, so parallel workers never share it
+thread_local Logger logger;
 
 #define FP_FRACTION_MD 18
 
 enum class NumKind { Decimal = 10, Hex = 16, Octal = 8, Binary = 2 };
 
-bool starts_with(const std::string &str, const std::string &cmp) {
-  return (str.compare(0, cmp.length(), cmp) == 0);
+enum class ParseError {
+  None,
+  Empty,             // nothing to parse
+  PrefixOnly,        // "0x", "0o", "0b" and nothing after
+  EmptySection,      // no digits (integer, fraction or exponent)
+  InvalidDigit,      // not a digit of the literal kind
+  Overflow,          // the digits don't fit in 64 bits
+  OutOfRange,        // float literal beyond the target range
+  InvalidKind,       // octal/binary float literal
+  InvalidEnd,        // float literal not ending with a digit
+  TooManyDots,       // more than one '.'
+  TooManyExponents,  // more than one exponent marker
+  MisplacedExponent, // exponent marker right after the '.'
+  ExponentBeforeDot, // exponent marker before the '.'
+  InvalidSuffix,     // suffix not valid for the target type
+};
+
+/*
+ * Result of the non-throwing parsers, they never allocate. `offset`
+ * is past the literal on success and at the failure otherwise, `kind`
+ * is the kind of the digits an error is about.
+ */
+template <typename T> struct ParseResult {
+  T value{};
+  ParseError error = ParseError::None;
+  size_t offset = 0;
+  NumKind kind = NumKind::Decimal;
+
+  constexpr explicit operator bool() const {
+    return error == ParseError::None;
+  }
+};
+
+constexpr NumKind numkind(std::string_view str) {
+  if (str.length() < 2 || str[0] != '0')
+    return NumKind::Decimal;
+
+  // the prefix letter as a (case insensitive) base 36 digit
+  switch (char_value(str[1])) {
+  case char_value('x'):
+    return NumKind::Hex;
+  case char_value('o'):
+    return NumKind::Octal;
+  case char_value('b'):
+    return NumKind::Binary;
+  default:
+    return NumKind::Decimal;
+  }
 }
 
 /*
  * Detect the number kind, and erases the part
  * resposible for detection.
  */
-NumKind numkind(const std::string &str, std::string &log) {
+NumKind numkind(std::string_view str, std::string &log) {
   if (str.empty())
     log += "Invalid argument: empty string\n";
 
-  if (starts_with(str, "0x") || starts_with(str, "0X"))
-    return NumKind::Hex;
+  NumKind kind = numkind(str);
 
-  else if (starts_with(str, "0o") || starts_with(str, "0O"))
-    return NumKind::Octal;
+  if (kind == NumKind::Decimal && !str.empty() && !is_digit(str.front()) &&
+      str.front() != '.')
+    log += "Invalid number start in: " + std::string(str) + "\n";
 
-  else if (starts_with(str, "0b") || starts_with(str, "0B"))
-    return NumKind::Binary;
+  return kind;
+}
 
-  else if (!str.empty() && !std::isdigit(str.front()) && str.front() != '.')
-    log += "Invalid number start in: " + str + "\n";
+/*
+ * Throw the exception the throwing parsers used to throw for `result`,
+ * `first` is what `result.offset` is relative to and `literal` the
+ * text used in the message.
+ */
+template <typename T>
+[[noreturn]] void throw_parse_error(const ParseResult<T> &result,
+                                    const char *first,
+                                    std::string_view literal) {
+  constexpr bool floating = std::is_floating_point<T>::value;
+  std::string str(literal);
 
-  return NumKind::Decimal;
-}
+  bool hex = (result.kind == NumKind::Hex);
+  const char *name = "decimal";
 
-uint64_t parse_hex(size_t start, const std::string &str, size_t end) {
-  if (end > str.length())
+  // clang-format off
+  switch (result.kind) {
+    case NumKind::Decimal: name = "decimal"; break;
+    case NumKind::Hex:     name = "hex";     break;
+    case NumKind::Octal:   name = "octal";   break;
+    case NumKind::Binary:  name = "binary";  break;
+  }
+  // clang-format on
+
+  // decimal/octal/binary messages quote the literal, hex ones don't
+  std::string quote = (hex || result.kind == NumKind::Binary) ? "" : "'";
+
+  switch (result.error) {
+  case ParseError::Empty:
     throw std::invalid_argument(
-        "end argument is bigger than the string length");
+        floating ? "Invalid floating point literal: empty string"
+                 : "Invalid argument: empty string");
 
-  bool valid = false;
+  case ParseError::PrefixOnly:
+    if (floating)
+      throw std::invalid_argument("invalid floating point literal: " + str);
+    throw std::invalid_argument("error, invalid integer");
+
+  case ParseError::EmptySection:
+    throw std::invalid_argument(std::string("Invalid ") + name + " literal: " +
+                                (hex ? "" : "'") + str);
+
+  case ParseError::InvalidDigit:
+    throw std::invalid_argument(std::string("Invalid ") + name + " digit '" +
+                                std::string(1, first[result.offset]) +
+                                "' in literal: " + str);
+
+  case ParseError::Overflow:
+    throw std::out_of_range(std::string(name) + " literal overflow: " + quote +
+                            str);
+
+  case ParseError::OutOfRange:
+    throw std::out_of_range("floating point literal overflow: " + str);
+
+  case ParseError::InvalidKind:
+    throw std::invalid_argument(
+        "float literals must be either Hex or Decimal: " + str);
+
+  case ParseError::InvalidEnd:
+    throw std::invalid_argument("Invalid floating point end: " + str);
+
+  case ParseError::TooManyDots:
+    throw std::invalid_argument("Too many '.' in floating point literal: " +
+                                str);
+
+  case ParseError::TooManyExponents:
+    throw std::invalid_argument(
+        "Too many scientific notations in floating point literal: " + str);
+
+  case ParseError::MisplacedExponent:
+    throw std::invalid_argument("Scientific notation can't come after a '.'");
+
+  case ParseError::ExponentBeforeDot:
+    throw std::invalid_argument("Scientific notation can't be before the '.'");
+
+  case ParseError::InvalidSuffix:
+    throw std::invalid_argument("Invalid suffix '" + str.substr(result.offset) +
+                                "' in literal: " + str);
+
+  case ParseError::None:
+    break;
+  }
+
+  throw std::logic_error("throw_parse_error() called without an error");
+}
+
+// the `n` lowest bits set
+constexpr uint64_t low_bits(size_t n) {
+  return (n >= 64) ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+}
+
+/*
+ * Separators stop the vector and SWAR kernels: when the first 64
+ * characters have some, they're stripped and `kernel` runs on the
+ * digits alone. Like the vector kernels it returns the characters used
+ * or 0, leaving misplaced separators (leading, trailing or doubled)
+ * and errors to the scalar loop.
+ */
+template <ParseResult<uint64_t> (*kernel)(const char *, const char *)>
+size_t without_separators(const char *first, const char *last, unsigned base,
+                          uint64_t &value) {
+  size_t window = std::min<size_t>(last - first, 64);
+  alignas(64) char digits[64 + 8];
+
+  // no separators or a leading one
+  uint64_t separators = strip_kernel(first, window, digits);
+  if (!separators || (separators & 1))
+    return 0;
+
+  // the padding ends the digits, the vector kernels can read it all
+  ParseResult<uint64_t> result = kernel(digits, digits + 64);
+  if (!result)
+    return 0;
+
+  // back to the input, each separator before the end moves it by one
+  size_t length = result.offset;
+  for (uint64_t skip = separators; skip; skip &= skip - 1) {
+    if ((size_t)__builtin_ctzll(skip) >= length)
+      break;
+    length++;
+  }
+
+  uint64_t used = separators & low_bits(length);
+  if ((used & (used >> 1)) || !digits_end(first, length, last - first, base))
+    return 0;
+
+  value = result.value;
+  return length;
+}
+
+/*
+ * The pointer range parsers below work like `std::from_chars()`: they
+ * parse the digits (and separators) at the start of `[first, last)`
+ * and stop at the first character that isn't part of the literal.
+ *
+ * The `ParseResult` versions never throw nor allocate, the others
+ * store the value, return a pointer past the literal and throw on
+ * errors.
+ */
+
+constexpr ParseResult<uint64_t> parse_hex(const char *first, const char *last) {
+  // up to 16 digits without separators in one go, when the CPU can
+  if (!__builtin_is_constant_evaluated() && hex_kernel) {
+    uint64_t value = 0;
+    if (size_t length = hex_kernel(first, last, value))
+      return {value, ParseError::None, length, NumKind::Hex};
+  }
+
+  bool valid = false, stripped = false;
   uint64_t result = 0;
 
-  for (size_t i = start; i < end; ++i) {
-    unsigned char c = str[i];
+  const char *p = first;
+  for (; p < last; ++p) {
+    unsigned char c = *p;
 
-    // skip separators
-    if (c == '\'')
+    // skip separators, the first one strips them all so the fast
+    // paths still apply
+    if (c == '\'') {
+      if (!stripped && !__builtin_is_constant_evaluated()) {
+        stripped = true;
+        uint64_t value = 0;
+        size_t length =
+            without_separators<parse_hex>(first, last, 16, value);
+        if (length)
+          return {value, ParseError::None, length, NumKind::Hex};
+      }
       continue;
+    }
 
-    int digit;
-
-    if (c >= '0' && c <= '9')
-      digit = c - '0';
-    else if (c >= 'a' && c <= 'f')
-      digit = c - 'a' + 10;
-    else if (c >= 'A' && c <= 'F')
-      digit = c - 'A' + 10;
-    else
-      throw std::invalid_argument("Invalid hex digit '" + std::string(1, c) +
-                                  "' in literal: " + str);
+    unsigned digit = char_value(c);
+    if (digit >= 16) {
+      if (valid)
+        break;
+      return {0, ParseError::InvalidDigit, (size_t)(p - first), NumKind::Hex};
+    }
 
     if (result > (UINT64_MAX >> 4))
-      throw std::out_of_range("hex literal overflow: " + str);
+      return {0, ParseError::Overflow, (size_t)(p - first), NumKind::Hex};
 
     result = (result << 4) | digit;
     valid = true;
   }
 
   if (!valid)
-    throw std::invalid_argument("Invalid hex literal: " + str);
+    return {0, ParseError::EmptySection, (size_t)(p - first), NumKind::Hex};
 
-  return result;
+  return {result, ParseError::None, (size_t)(p - first), NumKind::Hex};
 }
 
-uint64_t parse_dec(size_t start, const std::string &str, size_t end) {
-  if (end > str.length())
-    throw std::invalid_argument(
-        "end argument is bigger than the string length");
+/*
+ * SWAR (SIMD within a register) helpers, they work on 8 characters
+ * loaded into a uint64_t with the first character in the lowest byte.
+ */
+inline uint64_t load_8_chars(const char *p) {
+  uint64_t chunk;
+  std::memcpy(&chunk, p, sizeof(chunk));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  return chunk;
+}
+
+// true if all the 8 characters are in ['0', '9']
+constexpr bool is_8_digits(uint64_t chunk) {
+  return !(((chunk + 0x4646464646464646) | (chunk - 0x3030303030303030)) &
+           0x8080808080808080);
+}
+
+// leading '0's of 8 decimal digits, `chunk` must pass `is_8_digits()`
+constexpr size_t leading_zeros_8(uint64_t chunk) {
+  uint64_t digits = chunk - 0x3030303030303030;
+  return digits ? __builtin_ctzll(digits) / 8 : 8;
+}
+
+// value of 8 decimal digits, `chunk` must pass `is_8_digits()`
+constexpr uint32_t parse_8_digits(uint64_t chunk) {
+  const uint64_t mask = 0x000000FF000000FF;
+  const uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+
+  chunk -= 0x3030303030303030;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+
+  return (uint32_t)chunk;
+}
+
+/*
+ * Exactly `N` decimal digits at `p`, false if one isn't a digit or the
+ * value overflows. The first N % 8 go one by one, then 8 at a time,
+ * unrolled for the constant N; only the 20th digit can overflow so
+ * it's the only one checked.
+ */
+template <size_t N> inline bool parse_dec_n(const char *p, uint64_t &value) {
+  constexpr size_t fits = std::min<size_t>(N, 19);
+  constexpr size_t head = fits % 8;
+
+  uint64_t result = 0;
+  for (size_t i = 0; i < head; ++i) {
+    unsigned digit = (unsigned char)p[i] - '0';
+    if (digit >= 10)
+      return false;
+    result = (result * 10) + digit;
+  }
+
+  for (size_t i = head; i < fits; i += 8) {
+    uint64_t chunk = load_8_chars(p + i);
+    if (!is_8_digits(chunk))
+      return false;
+    result = (result * 100000000) + parse_8_digits(chunk);
+  }
+
+  if constexpr (N == 20) {
+    unsigned digit = (unsigned char)p[19] - '0';
+    if (digit >= 10 || __builtin_mul_overflow(result, 10, &result) ||
+        __builtin_add_overflow(result, digit, &result))
+      return false;
+  }
+
+  value = result;
+  return true;
+}
+
+// `parse_dec_n<length>()` for lengths in [1, 20], through a jump table
+inline bool parse_dec_length(const char *p, size_t length, uint64_t &value) {
+  // clang-format off
+  switch (length) {
+    case 1:  return parse_dec_n<1>(p, value);
+    case 2:  return parse_dec_n<2>(p, value);
+    case 3:  return parse_dec_n<3>(p, value);
+    case 4:  return parse_dec_n<4>(p, value);
+    case 5:  return parse_dec_n<5>(p, value);
+    case 6:  return parse_dec_n<6>(p, value);
+    case 7:  return parse_dec_n<7>(p, value);
+    case 8:  return parse_dec_n<8>(p, value);
+    case 9:  return parse_dec_n<9>(p, value);
+    case 10: return parse_dec_n<10>(p, value);
+    case 11: return parse_dec_n<11>(p, value);
+    case 12: return parse_dec_n<12>(p, value);
+    case 13: return parse_dec_n<13>(p, value);
+    case 14: return parse_dec_n<14>(p, value);
+    case 15: return parse_dec_n<15>(p, value);
+    case 16: return parse_dec_n<16>(p, value);
+    case 17: return parse_dec_n<17>(p, value);
+    case 18: return parse_dec_n<18>(p, value);
+    case 19: return parse_dec_n<19>(p, value);
+    case 20: return parse_dec_n<20>(p, value);
+    default: return false;
+  }
+  // clang-format on
+}
+
+constexpr ParseResult<uint64_t> parse_dec(const char *first, const char *last) {
+  const size_t base = 10;
+
+  bool valid = false, stripped = false;
+  uint64_t result = 0;
+
+  const char *p = first;
+  while (p < last) {
+    // 8 digits at a time, overflow is checked once per block (not at
+    // compile time, the load is a memcpy)
+    if (!__builtin_is_constant_evaluated() && last - p >= 8) {
+      uint64_t chunk = load_8_chars(p);
+
+      if (is_8_digits(chunk)) {
+        if (__builtin_mul_overflow(result, 100000000, &result) ||
+            __builtin_add_overflow(result, parse_8_digits(chunk), &result))
+          return {0, ParseError::Overflow, (size_t)(p - first)};
+
+        p += 8;
+        valid = true;
+        continue;
+      }
+    }
+
+    unsigned char c = *p;
+    // skip separators, the first one strips them all so the fast
+    // paths still apply
+    if (c == '\'') {
+      if (!stripped && !__builtin_is_constant_evaluated()) {
+        stripped = true;
+        uint64_t value = 0;
+        size_t length =
+            without_separators<parse_dec>(first, last, base, value);
+        if (length)
+          return {value, ParseError::None, length};
+      }
+      p++;
+      continue;
+    }
+
+    unsigned digit = char_value(c);
+    if (digit >= base) {
+      if (valid)
+        break;
+      return {0, ParseError::InvalidDigit, (size_t)(p - first)};
+    }
+
+    if (__builtin_mul_overflow(result, base, &result) ||
+        __builtin_add_overflow(result, digit, &result))
+      return {0, ParseError::Overflow, (size_t)(p - first)};
 
-  const static size_t base = 10;
+    p++;
+    valid = true;
+  }
+
+  if (!valid)
+    return {0, ParseError::EmptySection, (size_t)(p - first)};
 
+  return {result, ParseError::None, (size_t)(p - first)};
+}
+
+constexpr ParseResult<uint64_t> parse_oct(const char *first, const char *last) {
   bool valid = false;
   uint64_t result = 0;
 
-  for (size_t i = start; i < end; ++i) {
-    unsigned char c = str[i];
+  const char *p = first;
+  for (; p < last; ++p) {
+    unsigned char c = *p;
     // skip separators
     if (c == '\'')
       continue;
 
-    if (!std::isdigit(c))
-      throw std::invalid_argument("Invalid decimal digit '" +
-                                  std::string(1, c) + "' in literal: " + str);
+    unsigned digit = char_value(c);
+    if (digit >= 8) {
+      if (valid)
+        break;
+      return {0, ParseError::InvalidDigit, (size_t)(p - first),
+              NumKind::Octal};
+    }
 
-    int digit = c - '0';
-    if (result > (UINT64_MAX - digit) / base)
-      throw std::out_of_range("decimal literal overflow: '" + str);
+    if (result > (UINT64_MAX >> 3))
+      return {0, ParseError::Overflow, (size_t)(p - first), NumKind::Octal};
 
-    result = (result * base) + digit;
+    result = (result << 3) | digit;
     valid = true;
   }
 
   if (!valid)
-    throw std::invalid_argument("Invalid decimal literal: '" + str);
+    return {0, ParseError::EmptySection, (size_t)(p - first), NumKind::Octal};
 
-  return result;
+  return {result, ParseError::None, (size_t)(p - first), NumKind::Octal};
 }
 
-uint64_t parse_oct(size_t start, const std::string &str, size_t end) {
+constexpr ParseResult<uint64_t> parse_bin(const char *first, const char *last) {
+  // up to 64 digits without separators in a few compares
+  if (!__builtin_is_constant_evaluated() && bin_kernel) {
+    uint64_t value = 0;
+    if (size_t length = bin_kernel(first, last, value))
+      return {value, ParseError::None, length, NumKind::Binary};
+  }
+
+  bool valid = false, stripped = false;
+  uint64_t result = 0;
+
+  const char *p = first;
+  for (; p < last; ++p) {
+    unsigned char c = *p;
+    // skip separators, the first one strips them all so the fast
+    // paths still apply
+    if (c == '\'') {
+      if (!stripped && !__builtin_is_constant_evaluated()) {
+        stripped = true;
+        uint64_t value = 0;
+        size_t length =
+            without_separators<parse_bin>(first, last, 2, value);
+        if (length)
+          return {value, ParseError::None, length, NumKind::Binary};
+      }
+      continue;
+    }
+
+    unsigned digit = char_value(c);
+    if (digit >= 2) {
+      if (valid)
+        break;
+      return {0, ParseError::InvalidDigit, (size_t)(p - first),
+              NumKind::Binary};
+    }
+
+    if (result > (UINT64_MAX >> 1))
+      return {0, ParseError::Overflow, (size_t)(p - first), NumKind::Binary};
+
+    result = (result << 1) | digit;
+    valid = true;
+  }
+
+  if (!valid)
+    return {0, ParseError::EmptySection, (size_t)(p - first), NumKind::Binary};
+
+  return {result, ParseError::None, (size_t)(p - first), NumKind::Binary};
+}
+
+/*
+ * Throwing wrappers over a digit kernel, on the pointer range and on
+ * `[start, end)` of a string that must hold only digits.
+ */
+template <ParseResult<uint64_t> (*kernel)(const char *, const char *)>
+const char *parse_digits(const char *first, const char *last,
+                         uint64_t &value) {
+  ParseResult<uint64_t> result = kernel(first, last);
+  if (!result)
+    throw_parse_error(result, first, {first, (size_t)(last - first)});
+
+  value = result.value;
+  return first + result.offset;
+}
+
+template <ParseResult<uint64_t> (*kernel)(const char *, const char *)>
+uint64_t parse_digits(size_t start, const std::string &str, size_t end) {
   if (end > str.length())
     throw std::invalid_argument(
         "end argument is bigger than the string length");
 
+  const char *first = str.data() + start;
+
+  // the whole range is the literal, its length picks the kernel
+  uint64_t value = 0;
+  if constexpr (kernel == parse_dec)
+    if (parse_dec_length(first, end - start, value))
+      return value;
+
+  ParseResult<uint64_t> result = kernel(first, str.data() + end);
+
+  if (result && result.offset != end - start)
+    result.error = ParseError::InvalidDigit;
+
+  if (!result)
+    throw_parse_error(result, first, str);
+
+  return result.value;
+}
+
+const char *parse_hex(const char *first, const char *last, uint64_t &value) {
+  return parse_digits<parse_hex>(first, last, value);
+}
+
+uint64_t parse_hex(size_t start, const std::string &str, size_t end) {
+  return parse_digits<parse_hex>(start, str, end);
+}
+
+const char *parse_dec(const char *first, const char *last, uint64_t &value) {
+  return parse_digits<parse_dec>(first, last, value);
+}
+
+uint64_t parse_dec(size_t start, const std::string &str, size_t end) {
+  return parse_digits<parse_dec>(start, str, end);
+}
+
+const char *parse_oct(const char *first, const char *last, uint64_t &value) {
+  return parse_digits<parse_oct>(first, last, value);
+}
+
+uint64_t parse_oct(size_t start, const std::string &str, size_t end) {
+  return parse_digits<parse_oct>(start, str, end);
+}
+
+const char *parse_bin(const char *first, const char *last, uint64_t &value) {
+  return parse_digits<parse_bin>(first, last, value);
+}
+
+uint64_t parse_bin(size_t start, const std::string &str, size_t end) {
+  return parse_digits<parse_bin>(start, str, end);
+}
+
+/*
+ * Collect the decimal digits in `[first, last)` into `digits`, used for
+ * the integer and fraction sections of a float literal. Only the first
+ * 19 digits are kept, so there's no overflow, other errors are the
+ * same as `parse_dec()`.
+ */
+constexpr ParseResult<bool> gather_dec(const char *first, const char *last,
+                                       bool fraction, DecimalDigits &digits) {
   bool valid = false;
-  uint64_t result = 0;
 
-  for (size_t i = start; i < end; ++i) {
-    unsigned char c = str[i];
+  const char *p = first;
+  while (p < last) {
+    if (!__builtin_is_constant_evaluated() && last - p >= 8 &&
+        digits.count + 8 <= 19) {
+      uint64_t chunk = load_8_chars(p);
+
+      if (is_8_digits(chunk)) {
+        digits.mantissa = (digits.mantissa * 100000000) + parse_8_digits(chunk);
+
+        // leading zeros aren't significant digits
+        digits.count += 8 - (digits.count ? 0 : leading_zeros_8(chunk));
+        if (fraction)
+          digits.exponent -= 8;
+
+        p += 8;
+        valid = true;
+        continue;
+      }
+    }
+
+    unsigned char c = *p;
     // skip separators
-    if (c == '\'')
+    if (c == '\'') {
+      p++;
       continue;
+    }
 
-    if (c < '0' || c > '7')
-      throw std::invalid_argument("Invalid octal digit '" + std::string(1, c) +
-                                  "' in literal: " + str);
+    unsigned digit = char_value(c);
+    if (digit >= 10)
+      return {false, ParseError::InvalidDigit, (size_t)(p - first)};
 
-    int digit = c - '0';
-    if (result > (UINT64_MAX >> 3))
-      throw std::out_of_range("octal literal overflow: '" + str);
+    p++;
+    valid = true;
 
-    result = (result << 3) | digit;
+    // leading zeros
+    if (digits.count == 0 && digit == 0) {
+      if (fraction)
+        digits.exponent--;
+      continue;
+    }
+
+    if (digits.count < 19) {
+      digits.mantissa = (digits.mantissa * 10) + digit;
+      if (fraction)
+        digits.exponent--;
+    } else {
+      digits.truncated |= (digit != 0);
+      if (!fraction)
+        digits.exponent++;
+    }
+
+    digits.count++;
+  }
+
+  if (!valid)
+    return {false, ParseError::EmptySection, (size_t)(p - first)};
+
+  return {true, ParseError::None, (size_t)(p - first)};
+}
+
+/*
+ * Collect the hex digits in `[first, last)` into `digits`, errors are
+ * the same as `parse_hex()` except there's no overflow.
+ */
+constexpr ParseResult<bool> gather_hex(const char *first, const char *last,
+                                       bool fraction, HexDigits &digits) {
+  bool valid = false;
+
+  const char *p = first;
+  for (; p < last; ++p) {
+    unsigned char c = *p;
+
+    // skip separators
+    if (c == '\'')
+      continue;
+
+    unsigned digit = char_value(c);
+    if (digit >= 16)
+      return {false, ParseError::InvalidDigit, (size_t)(p - first),
+              NumKind::Hex};
+
+    digits.append(digit, fraction);
     valid = true;
   }
 
-  if (!valid)
-    throw std::invalid_argument("Invalid octal literal: '" + str);
+  if (!valid)
+    return {false, ParseError::EmptySection, (size_t)(p - first),
+            NumKind::Hex};
+
+  return {true, ParseError::None, (size_t)(p - first), NumKind::Hex};
+}
+
+/*
+ * Parse the `[sign]<digits>` exponent of a float literal in
+ * `[first, last)`, huge values are clamped since they're inf/0 anyway.
+ */
+constexpr ParseResult<int64_t> parse_exponent(const char *first,
+                                              const char *last) {
+  bool negative = false;
+  size_t sign = 0;
+
+  if (first < last && (*first == '-' || *first == '+')) {
+    negative = (*first == '-');
+    sign = 1;
+  }
+
+  ParseResult<uint64_t> exponent = parse_dec(first + sign, last);
+  exponent.offset += sign;
+
+  if (exponent && first + exponent.offset != last)
+    exponent.error = ParseError::InvalidDigit;
+
+  if (!exponent)
+    return {0, exponent.error, exponent.offset};
+
+  int64_t value = std::min<uint64_t>(exponent.value, 1 << 24);
+  return {negative ? -value : value, ParseError::None, exponent.offset};
+}
+
+// the integer literal `[first, last)` before its conversion to int64_t
+constexpr ParseResult<uint64_t> parse_unsigned(const char *first,
+                                               const char *last) {
+  if (first == last)
+    return {0, ParseError::Empty};
+
+  NumKind kind = numkind({first, (size_t)(last - first)});
+  size_t prefix = (kind != NumKind::Decimal) ? 2 : 0;
+
+  if ((size_t)(last - first) == prefix)
+    return {0, ParseError::PrefixOnly, prefix, kind};
+
+  ParseResult<uint64_t> result;
+
+  // clang-format off
+  switch (kind) {
+    case NumKind::Decimal: result = parse_dec(first, last); break;
+    case NumKind::Hex:     result = parse_hex(first + 2, last); break;
+    case NumKind::Octal:   result = parse_oct(first + 2, last); break;
+    case NumKind::Binary:  result = parse_bin(first + 2, last); break;
+  }
+  // clang-format on
+
+  return {result.value, result.error, result.offset + prefix, kind};
+}
+
+constexpr ParseResult<int64_t> parse_integer(const char *first,
+                                             const char *last) {
+  ParseResult<uint64_t> result = parse_unsigned(first, last);
+  return {(int64_t)result.value, result.error, result.offset, result.kind};
+}
+
+const char *parse_integer(const char *first, const char *last,
+                          int64_t &value) {
+  ParseResult<int64_t> result = parse_integer(first, last);
+  if (!result)
+    throw_parse_error(result, first, {first, (size_t)(last - first)});
+
+  value = result.value;
+  return first + result.offset;
+}
+
+int64_t parse_integer(const std::string &str) {
+  uint64_t value = 0;
+  if (parse_dec_length(str.data(), str.length(), value))
+    return (int64_t)value;
+
+  ParseResult<int64_t> result =
+      parse_integer(str.data(), str.data() + str.length());
+
+  if (result && result.offset != str.length())
+    result.error = ParseError::InvalidDigit;
+
+  if (!result)
+    throw_parse_error(result, str.data(), str);
+
+  return result.value;
+}
+
+/*
+ * Integers past 64 bits, the opt-in alternative to the Overflow error:
+ * `value` holds up to 128 bits, bigger values are in `limbs` instead
+ * (little-endian 64-bit limbs, `value` is then 0).
+ */
+struct WideInteger {
+  unsigned __int128 value = 0;
+  std::vector<uint64_t> limbs;
+};
+
+// limbs = limbs * m + a
+inline void mul_add(std::vector<uint64_t> &limbs, uint64_t m, uint64_t a) {
+  for (uint64_t &limb : limbs) {
+    unsigned __int128 p = (unsigned __int128)limb * m + a;
+    limb = (uint64_t)p;
+    a = (uint64_t)(p >> 64);
+  }
+
+  if (a != 0)
+    limbs.push_back(a);
+}
+
+/*
+ * Value of the valid digits (and separators) in `[first, last)`:
+ * decimals 19 digits at a time, each chunk a single multiply-add over
+ * the limbs, power of two bases packed bit by bit from the last digit.
+ */
+inline WideInteger wide_digits(const char *first, const char *last,
+                               unsigned base) {
+  WideInteger result;
+  std::vector<uint64_t> &limbs = result.limbs;
+
+  if (base == 10) {
+    uint64_t chunk = 0, scale = 1;
+
+    for (const char *p = first; p < last; ++p) {
+      if (*p == '\'')
+        continue;
+
+      chunk = (chunk * 10) + char_value(*p);
+      scale *= 10;
+
+      // 10^19 is the biggest power of 10 in 64 bits
+      if (scale == 10000000000000000000ULL) {
+        mul_add(limbs, scale, chunk);
+        chunk = 0;
+        scale = 1;
+      }
+    }
+
+    if (scale != 1)
+      mul_add(limbs, scale, chunk);
+  } else {
+    size_t bits = __builtin_ctz(base);
+    limbs.reserve((((last - first) * bits) / 64) + 1);
+
+    size_t position = 0;
+    for (const char *p = last; p-- > first;) {
+      if (*p == '\'')
+        continue;
+
+      uint64_t digit = char_value(*p);
+      size_t limb = position / 64, shift = position % 64;
+
+      if (limb >= limbs.size())
+        limbs.push_back(0);
+      limbs[limb] |= digit << shift;
+
+      // an octal digit can straddle two limbs
+      if (shift + bits > 64)
+        limbs.push_back(digit >> (64 - shift));
+
+      position += bits;
+    }
+  }
+
+  while (!limbs.empty() && limbs.back() == 0)
+    limbs.pop_back();
+
+  if (limbs.size() <= 2) {
+    for (size_t i = limbs.size(); i-- > 0;)
+      result.value = (result.value << 64) | limbs[i];
+    limbs.clear();
+  }
+
+  return result;
+}
+
+/*
+ * parse_unsigned() first, the wide conversion only runs on its Overflow
+ * error so literals that fit in 64 bits cost the same.
+ */
+ParseResult<WideInteger> parse_wide_integer(const char *first,
+                                            const char *last) {
+  ParseResult<uint64_t> narrow = parse_unsigned(first, last);
+  if (narrow.error != ParseError::Overflow)
+    return {{narrow.value, {}}, narrow.error, narrow.offset, narrow.kind};
+
+  unsigned base = (unsigned)narrow.kind;
+  const char *digits = first + ((narrow.kind != NumKind::Decimal) ? 2 : 0);
+
+  // the kernels stop at the first character that isn't a digit nor a
+  // separator, there are digits before it
+  const char *end = digits;
+  while (end < last && (char_value(*end) < base || *end == '\''))
+    end++;
+
+  return {wide_digits(digits, end, base), ParseError::None,
+          (size_t)(end - first), narrow.kind};
+}
+
+WideInteger parse_wide_integer(const std::string &str) {
+  ParseResult<WideInteger> result =
+      parse_wide_integer(str.data(), str.data() + str.length());
+
+  if (result && result.offset != str.length())
+    result.error = ParseError::InvalidDigit;
+
+  if (!result)
+    throw_parse_error(result, str.data(), str);
+
+  return std::move(result.value);
+}
+
+/*
+ * End of the float literal starting at `first`: digits of its kind,
+ * separators, '.', the exponent marker and a sign right after it.
+ */
+constexpr const char *float_literal_end(const char *first,
+                                        const char *last) {
+  NumKind kind = numkind({first, (size_t)(last - first)});
+  bool hex = (kind == NumKind::Hex);
+  bool exponent = false;
+
+  uint8_t mantissa = CharClass::Digit | CharClass::Separator | CharClass::Dot |
+                     (hex ? CharClass::XDigit : 0);
+  uint8_t marker = hex ? CharClass::HexExponent : CharClass::DecExponent;
+
+  const char *p = first + ((kind != NumKind::Decimal) ? 2 : 0);
+  for (; p < last; ++p) {
+    uint8_t cls = char_class(*p);
+
+    if (cls & (exponent ? CharClass::Digit | CharClass::Separator : mantissa))
+      continue;
+
+    if (!exponent && (cls & marker)) {
+      exponent = true;
+      if (p + 1 < last && (char_class(p[1]) & CharClass::Sign))
+        p++;
+      continue;
+    }
+
+    break;
+  }
+
+  return (p > last) ? last : p;
+}
+
+/*
+ * The whole `str` is the float literal. It's classified, validated and
+ * accumulated in a single forward pass; structural errors (dots and
+ * exponent markers) are reported before digit errors, like the
+ * separate checks used to.
+ */
+template <typename T>
+constexpr ParseResult<T> float_literal(std::string_view str) {
+  using Result = ParseResult<T>;
+  constexpr size_t npos = std::string_view::npos;
+
+  if (str.empty())
+    return Result{0, ParseError::Empty};
+
+  NumKind kind = numkind(str);
+  size_t current_character = (kind != NumKind::Decimal) ? 2 : 0;
+
+  if ((str.length() - current_character) == 0)
+    return Result{0, ParseError::PrefixOnly, current_character, kind};
+
+  else if (kind == NumKind::Octal || kind == NumKind::Binary)
+    return Result{0, ParseError::InvalidKind, 0, kind};
+
+  else if (kind == NumKind::Hex ? !is_xdigit(str.back())
+                                : !is_digit(str.back()))
+    return Result{0, ParseError::InvalidEnd, str.length() - 1, kind};
+
+  enum class Section { Integer, Fraction, Exponent };
+  Section section = Section::Integer;
+
+  bool hex = (kind == NumKind::Hex);
+  uint8_t marker = hex ? CharClass::HexExponent : CharClass::DecExponent;
+
+  size_t has_dot = npos, has_sn = npos;
+  size_t extra_dot = npos, extra_sn = npos;
+
+  DecimalDigits decimal;
+  HexDigits digits;
+  uint64_t exponent = 0;
+  bool negative = false;
+
+  // digits in the current section, first error of the sections
+  bool seen = false;
+  Result error{0, ParseError::None};
+
+  auto fail = [&](ParseError reason, size_t at) {
+    if (error) {
+      NumKind digits_kind =
+          (section == Section::Exponent) ? NumKind::Decimal : kind;
+      error = Result{0, reason, at, digits_kind};
+    }
+  };
+
+  // a decimal literal starting with '.' has no integer section
+  auto end_section = [&](size_t at) {
+    if (!seen && !(section == Section::Integer && !hex && at == 0 &&
+                   has_dot == 0))
+      fail(ParseError::EmptySection, at);
+    seen = false;
+  };
+
+  for (size_t i = current_character; i < str.length(); ++i) {
+    unsigned char c = str[i];
+    uint8_t cls = char_class(c);
+
+    // 8 decimal digits at a time while they fit the 19 kept
+    if (!hex && (cls & CharClass::Digit) && section != Section::Exponent &&
+        !__builtin_is_constant_evaluated() && str.length() - i >= 8 &&
+        decimal.count + 8 <= 19 && error) {
+      uint64_t chunk = load_8_chars(str.data() + i);
+
+      if (is_8_digits(chunk)) {
+        decimal.mantissa =
+            (decimal.mantissa * 100000000) + parse_8_digits(chunk);
+
+        // leading zeros aren't significant digits
+        decimal.count += 8 - (decimal.count ? 0 : leading_zeros_8(chunk));
+        if (section == Section::Fraction)
+          decimal.exponent -= 8;
+
+        seen = true;
+        i += 7;
+        continue;
+      }
+    }
+
+    if (cls & CharClass::Separator)
+      continue;
+
+    if (cls & marker) {
+      if (has_sn != npos) {
+        if (extra_sn == npos)
+          extra_sn = i;
+        continue;
+      }
+
+      has_sn = i;
+      end_section(i);
+      section = Section::Exponent;
+      continue;
+    }
+
+    if (cls & CharClass::Dot) {
+      if (has_dot != npos) {
+        if (extra_dot == npos)
+          extra_dot = i;
+        continue;
+      }
+
+      has_dot = i;
+
+      // a dot in the exponent is reported at the end
+      if (section == Section::Integer) {
+        end_section(i);
+        section = Section::Fraction;
+      }
+      continue;
+    }
+
+    if ((cls & CharClass::Sign) && section == Section::Exponent &&
+        i == has_sn + 1) {
+      negative = (c == '-');
+      continue;
+    }
+
+    unsigned digit = char_value(c);
+    if (digit >= ((hex && section != Section::Exponent) ? 16 : 10)) {
+      fail(ParseError::InvalidDigit, i);
+      continue;
+    }
+
+    seen = true;
+    if (!error)
+      continue;
+
+    if (section == Section::Exponent) {
+      if (exponent > (UINT64_MAX - digit) / 10)
+        fail(ParseError::Overflow, i);
+      exponent = (exponent * 10) + digit;
+    } else if (hex) {
+      digits.append(digit, section == Section::Fraction);
+    } else {
+      bool fraction = (section == Section::Fraction);
+
+      // leading zeros
+      if (decimal.count == 0 && digit == 0) {
+        if (fraction)
+          decimal.exponent--;
+        continue;
+      }
+
+      if (decimal.count < 19) {
+        decimal.mantissa = (decimal.mantissa * 10) + digit;
+        if (fraction)
+          decimal.exponent--;
+      } else {
+        decimal.truncated |= (digit != 0);
+        if (!fraction)
+          decimal.exponent++;
+      }
+
+      decimal.count++;
+    }
+  }
+
+  end_section(str.length());
+
+  if (extra_dot != npos)
+    return Result{0, ParseError::TooManyDots, extra_dot, kind};
+
+  if (extra_sn != npos)
+    return Result{0, ParseError::TooManyExponents, extra_sn, kind};
+
+  if (has_dot != npos && has_sn != npos) {
+    if (has_dot + 1 == has_sn)
+      return Result{0, ParseError::MisplacedExponent, has_sn, kind};
+
+    if (has_sn < has_dot)
+      return Result{0, ParseError::ExponentBeforeDot, has_sn, kind};
+  }
+
+  if (!error)
+    return error;
+
+  // huge exponents are inf/0 anyway
+  int64_t scale = std::min<uint64_t>(exponent, 1 << 24);
+  if (negative)
+    scale = -scale;
+
+  const char *first = str.data() + current_character;
+  const char *last = str.data() + std::min(has_sn, str.length());
+
+  T result = hex ? hex_to_float<T>(digits, scale)
+                 : decimal_to_float<T>(decimal, first, last, scale);
+
+  // never negative nor NaN, std::isfinite() isn't constexpr
+  if (result > std::numeric_limits<T>::max())
+    return Result{result, ParseError::OutOfRange, 0, kind};
+
+  return Result{result, ParseError::None, str.length(), kind};
+}
+
+ParseResult<long double> parse_floating_point(const char *first,
+                                              const char *last) {
+  const char *end = float_literal_end(first, last);
+  return float_literal<long double>({first, (size_t)(end - first)});
+}
+
+const char *parse_floating_point(const char *first, const char *last,
+                                 long double &value) {
+  const char *end = float_literal_end(first, last);
+
+  ParseResult<long double> result =
+      float_literal<long double>({first, (size_t)(end - first)});
+  if (!result)
+    throw_parse_error(result, first, {first, (size_t)(end - first)});
+
+  value = result.value;
+  return end;
+}
+
+long double parse_floating_point(const std::string &str) {
+  ParseResult<long double> result = float_literal<long double>(str);
+  if (!result)
+    throw_parse_error(result, str.data(), str);
+
+  return result.value;
+}
+
+/*
+ * Decimal literal as a scaled integer, `value` is the literal times
+ * 10^scale rounded half to even (1234.5678 with scale 2 is 123457).
+ * `exact` is false when digits were rounded away. There's no floating
+ * point involved, T can be any integer up to unsigned __int128.
+ */
+template <typename T> struct ScaledDecimal {
+  T value = 0;
+  bool exact = true;
+};
+
+/*
+ * The whole `[first, last)` is the decimal literal. Errors are the float
+ * literal ones, OutOfRange when the scaled value doesn't fit in T.
+ */
+template <typename T = int64_t>
+constexpr ParseResult<ScaledDecimal<T>>
+parse_scaled_decimal(const char *first, const char *last, int scale) {
+  using Result = ParseResult<ScaledDecimal<T>>;
+
+  if (first == last)
+    return Result{{}, ParseError::Empty};
+
+  NumKind kind = numkind({first, (size_t)(last - first)});
+  if (kind != NumKind::Decimal)
+    return Result{{}, ParseError::InvalidKind, 0, kind};
+
+  const char *marker = first;
+  while (marker < last && !(char_class(*marker) & CharClass::DecExponent))
+    marker++;
+
+  int64_t exponent = 0;
+  if (marker < last) {
+    ParseResult<int64_t> parsed = parse_exponent(marker + 1, last);
+    if (!parsed)
+      return Result{{}, parsed.error,
+                    (size_t)(marker + 1 - first) + parsed.offset};
+    exponent = parsed.value;
+  }
+
+  // the power of 10 of the first digit, each digit one less
+  const char *dot = last;
+  int64_t power = exponent + scale - 1;
+
+  for (const char *p = first; p < marker; ++p) {
+    if (*p == '.') {
+      if (dot != last)
+        return Result{{}, ParseError::TooManyDots, (size_t)(p - first)};
+      dot = p;
+    } else if (dot == last && *p != '\'') {
+      power++;
+    }
+  }
+
+  // digits of power 0 and up are the value, -1 rounds and the rest only
+  // decide ties
+  T value = 0;
+  unsigned round = 0;
+  bool sticky = false, seen = false;
+
+  for (const char *p = first; p < marker; ++p) {
+    if (*p == '\'')
+      continue;
+
+    if (p == dot) {
+      if (!seen && p != first)
+        return Result{{}, ParseError::EmptySection, (size_t)(p - first)};
+      seen = false;
+      continue;
+    }
+
+    unsigned digit = char_value(*p);
+    if (digit >= 10)
+      return Result{{}, ParseError::InvalidDigit, (size_t)(p - first)};
+
+    if (power >= 0) {
+      if (__builtin_mul_overflow(value, 10, &value) ||
+          __builtin_add_overflow(value, digit, &value))
+        return Result{{}, ParseError::OutOfRange};
+    } else if (power == -1) {
+      round = digit;
+    } else {
+      sticky |= (digit != 0);
+    }
+
+    power--;
+    seen = true;
+  }
+
+  if (!seen)
+    return Result{{}, ParseError::EmptySection, (size_t)(marker - first)};
+
+  // trailing zeros of a positive exponent or scale
+  for (; power >= 0 && value != 0; power--)
+    if (__builtin_mul_overflow(value, 10, &value))
+      return Result{{}, ParseError::OutOfRange};
+
+  if (round > 5 || (round == 5 && (sticky || (value & 1))))
+    if (__builtin_add_overflow(value, 1, &value))
+      return Result{{}, ParseError::OutOfRange};
+
+  return Result{{value, round == 0 && !sticky}, ParseError::None,
+                (size_t)(last - first)};
+}
+
+// InvalidKind and OutOfRange messages of their own, the float ones would
+// say hex is fine and talk about floating point
+template <typename T>
+[[noreturn]] void
+throw_scaled_error(const ParseResult<ScaledDecimal<T>> &result,
+                   const char *first, std::string_view literal) {
+  if (result.error == ParseError::InvalidKind)
+    throw std::invalid_argument("scaled decimal literals must be decimal: " +
+                                std::string(literal));
+
+  if (result.error == ParseError::OutOfRange)
+    throw std::out_of_range("scaled value out of range: " +
+                            std::string(literal));
+
+  throw_parse_error(result, first, literal);
+}
+
+template <typename T = int64_t>
+const char *parse_scaled_decimal(const char *first, const char *last,
+                                 int scale, ScaledDecimal<T> &value) {
+  const char *end = float_literal_end(first, last);
+
+  ParseResult<ScaledDecimal<T>> result =
+      parse_scaled_decimal<T>(first, end, scale);
+  if (!result)
+    throw_scaled_error(result, first, {first, (size_t)(end - first)});
+
+  value = result.value;
+  return end;
+}
+
+template <typename T = int64_t>
+ScaledDecimal<T> parse_scaled_decimal(const std::string &str, int scale) {
+  ParseResult<ScaledDecimal<T>> result =
+      parse_scaled_decimal<T>(str.data(), str.data() + str.length(), scale);
+  if (!result)
+    throw_scaled_error(result, str.data(), str);
+
+  return result.value;
+}
+
+// true if the decimal/hex `str` has a '.' or an exponent
+constexpr bool is_float_literal(std::string_view str) {
+  switch (numkind(str)) {
+  case NumKind::Decimal:
+    return str.find_first_of(".eE") != std::string_view::npos;
+  case NumKind::Hex:
+    return str.find_first_of(".pP") != std::string_view::npos;
+  default:
+    return false;
+  }
+}
+
+/*
+ * Whether the literal suffix `suffix` is valid for a T: `f`/`F` for
+ * float, `l`/`L` for long double, C's `u`, `l` and `ll` (in any order,
+ * `u` for unsigned targets, `l`s for targets at least that wide) and the
+ * exact width ones like `i32` and `u8`. No suffix is valid for every T.
+ */
+template <typename T> constexpr bool valid_suffix(std::string_view suffix) {
+  if (suffix.empty())
+    return true;
+
+  if constexpr (std::is_floating_point<T>::value) {
+    if (suffix == "f" || suffix == "F")
+      return std::is_same<T, float>::value;
+    if (suffix == "l" || suffix == "L")
+      return std::is_same<T, long double>::value;
+    return false;
+  } else {
+    constexpr size_t bits = sizeof(T) * 8;
+    constexpr bool is_unsigned = std::is_unsigned<T>::value;
+
+    // spelled exactly, no separators nor leading zeros
+    constexpr std::string_view width = (bits == 8)    ? "8"
+                                       : (bits == 16) ? "16"
+                                       : (bits == 32) ? "32"
+                                                      : "64";
+
+    if ((suffix[0] == 'i' || suffix[0] == 'u') && suffix.length() > 1 &&
+        is_digit(suffix[1]))
+      return suffix.substr(1) == width && (suffix[0] == 'u') == is_unsigned;
+
+    bool u = false;
+    size_t longs = 0;
+
+    for (size_t i = 0; i < suffix.length(); ++i) {
+      char c = suffix[i];
+
+      if ((c == 'u' || c == 'U') && !u) {
+        u = true;
+      } else if ((c == 'l' || c == 'L') && longs == 0) {
+        // "ll" or "LL", never mixed
+        longs = (i + 1 < suffix.length() && suffix[i + 1] == c) ? 2 : 1;
+        i += longs - 1;
+      } else {
+        return false;
+      }
+    }
+
+    size_t min_bits = (longs == 2)   ? sizeof(long long) * 8
+                      : (longs == 1) ? sizeof(long) * 8
+                                     : 0;
+    return (!u || is_unsigned) && bits >= min_bits;
+  }
+}
+
+/*
+ * The whole `[first, last)` is a literal, with an optional suffix,
+ * converted to T. Integer targets check the value against T's limits
+ * (Overflow), float and double targets never compute in long double.
+ */
+template <typename T>
+constexpr ParseResult<T> parse(const char *first, const char *last) {
+  static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                "integer or floating point targets only");
+  using Result = ParseResult<T>;
+
+  const char *end = last;
+  Result result;
+
+  if constexpr (std::is_floating_point<T>::value) {
+    end = float_literal_end(first, last);
+    result = float_literal<T>({first, (size_t)(end - first)});
+  } else {
+    ParseResult<uint64_t> digits = parse_unsigned(first, last);
+    end = first + digits.offset;
+
+    result = Result{(T)digits.value, digits.error, digits.offset, digits.kind};
+    if (digits && digits.value > (uint64_t)std::numeric_limits<T>::max())
+      result = Result{0, ParseError::Overflow,
+                      (digits.kind != NumKind::Decimal) ? 2u : 0u,
+                      digits.kind};
+  }
+
+  // the parsers stop at anything that isn't a digit, only a letter
+  // starts a suffix
+  if (result && end < last && ((*end | 0x20) < 'a' || (*end | 0x20) > 'z'))
+    result = Result{0, ParseError::InvalidDigit, (size_t)(end - first),
+                    result.kind};
+
+  if (!result)
+    return result;
+
+  if (!valid_suffix<T>({end, (size_t)(last - end)}))
+    return Result{0, ParseError::InvalidSuffix, (size_t)(end - first),
+                  result.kind};
+
+  result.offset = last - first;
+  return result;
+}
+
+template <typename T> T parse(const std::string &str) {
+  ParseResult<T> result = parse<T>(str.data(), str.data() + str.length());
+  if (!result)
+    throw_parse_error(result, str.data(), str);
+
+  return result.value;
+}
+
+/*
+ * Compile-time parsing with the `_np` literal suffix: `0x1'0000_np`,
+ * `1.5e3_np` and, with GNU compilers, `"0o17"_np`. Integers are
+ * uint64_t, floats long double and a malformed literal doesn't build.
+ */
+template <char... Cs> constexpr char np_literal[] = {Cs..., '\0'};
+
+template <const char *literal, size_t length> constexpr auto parse_np() {
+  constexpr std::string_view str(literal, length);
+
+  if constexpr (is_float_literal(str)) {
+    constexpr ParseResult<long double> result =
+        float_literal<long double>(str);
+    static_assert(result.error == ParseError::None,
+                  "invalid floating point literal");
+
+    return result.value;
+  } else {
+    constexpr ParseResult<int64_t> result =
+        parse_integer(str.data(), str.data() + str.length());
+    static_assert(result.error == ParseError::None && result.offset == length,
+                  "invalid integer literal");
+
+    return (uint64_t)result.value;
+  }
+}
+
+template <char... Cs> constexpr auto operator""_np() {
+  // C++ reads 017 as octal, this parser as decimal
+  static_assert(sizeof...(Cs) < 2 || np_literal<Cs...>[0] != '0' ||
+                    !is_digit(np_literal<Cs...>[1]) ||
+                    is_float_literal(np_literal<Cs...>),
+                "ambiguous leading 0, use \"0o...\"_np for octal");
+
+  return parse_np<np_literal<Cs...>, sizeof...(Cs)>();
+}
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+
+template <typename Char, Char... Cs> constexpr auto operator""_np() {
+  static_assert(std::is_same<Char, char>::value, "only narrow literals");
+  return parse_np<np_literal<Cs...>, sizeof...(Cs)>();
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+/*
+ * Memo of parse results in front of `parse`, for inputs where a few
+ * distinct literals make most of the occurrences. Literals of up to 24
+ * bytes are keyed by their bytes in a flat open-addressed table of
+ * `capacity` entries, allocated once; longer ones always go to `parse`.
+ * When a literal's probe window is full it replaces the entry at its
+ * home slot, so the table never grows. Not thread safe, one per thread.
+ */
+template <typename T, ParseResult<T> (*parse)(const char *, const char *),
+          size_t capacity = 4096>
+class LiteralCache {
+  static_assert((capacity & (capacity - 1)) == 0, "power of 2 capacity");
+
+public:
+  ParseResult<T> operator()(const char *first, const char *last) {
+    size_t length = last - first;
+    if (length == 0 || length > sizeof(Key)) {
+      counted_misses++;
+      return parse(first, last);
+    }
+
+    Key key{};
+    std::memcpy(key.words, first, length);
+
+    // the length makes the tag of a used entry non-zero
+    uint64_t hash = key.hash(length);
+    uint32_t tag = ((uint32_t)(hash >> 32) << 5) | (uint32_t)length;
+
+    size_t home = (size_t)hash & (capacity - 1);
+    for (size_t i = 0; i < probes; ++i) {
+      Entry &entry = entries[(home + i) & (capacity - 1)];
+
+      if (entry.tag == 0) {
+        counted_misses++;
+        entry = {tag, key, parse(first, last)};
+        return entry.result;
+      }
+
+      if (entry.tag == tag && entry.key == key) {
+        counted_hits++;
+        return entry.result;
+      }
+    }
+
+    counted_misses++;
+    Entry &entry = entries[home];
+    entry = {tag, key, parse(first, last)};
+    return entry.result;
+  }
+
+  uint64_t hits() const { return counted_hits; }
+  uint64_t misses() const { return counted_misses; }
+
+  void clear() {
+    std::fill(entries.get(), entries.get() + capacity, Entry{});
+    counted_hits = counted_misses = 0;
+  }
+
+private:
+  static constexpr size_t probes = 8;
+
+  // the literal zero padded, its length is in the hash and the tag
+  struct Key {
+    uint64_t words[3];
+
+    bool operator==(const Key &other) const {
+      return ((words[0] ^ other.words[0]) | (words[1] ^ other.words[1]) |
+              (words[2] ^ other.words[2])) == 0;
+    }
 
-  return result;
-}
+    uint64_t hash(size_t length) const {
+      uint64_t h = (words[0] * 0x9E3779B97F4A7C15ULL) ^
+                   (words[1] * 0xC2B2AE3D27D4EB4FULL) ^
+                   (words[2] * 0x165667B19E3779F9ULL) ^ length;
+      return h ^ (h >> 29);
+    }
+  };
 
-uint64_t parse_bin(size_t start, const std::string &str, size_t end) {
-  if (end > str.length())
-    throw std::invalid_argument(
-        "end argument is bigger than the string length");
+  // `tag` is 0 for an empty entry
+  struct Entry {
+    uint32_t tag = 0;
+    Key key{};
+    ParseResult<T> result;
+  };
 
-  bool valid = false;
-  uint64_t result = 0;
+  std::unique_ptr<Entry[]> entries{new Entry[capacity]};
+  uint64_t counted_hits = 0;
+  uint64_t counted_misses = 0;
+};
 
-  for (size_t i = start; i < end; ++i) {
-    unsigned char c = str[i];
-    // skip separators
-    if (c == '\'')
-      continue;
+using FloatingPointCache = LiteralCache<long double, parse_floating_point>;
+
+/*
+ * Batch parsers, for columns of literals packed in one buffer. Literal
+ * `i` is either `[buffer + offsets[i], buffer + offsets[i + 1])` or the
+ * `i`th field between `delimiter`s (a trailing one doesn't start an
+ * empty field). Its value is stored to `values[i]` and bit `i` (LSB
+ * first) of the `valid` bitmap is set if the whole literal parsed,
+ * invalid literals store 0. They return the number of fields, never
+ * throw nor allocate.
+ */
 
-    if (c != '0' && c != '1')
-      throw std::invalid_argument("Invalid binary digit '" + std::string(1, c) +
-                                  "' in literal: " + str);
+using DigitKernel = ParseResult<uint64_t> (*)(const char *, const char *);
 
-    if (result > (UINT64_MAX >> 1))
-      throw std::out_of_range("binary literal overflow: " + str);
+// kernel for the integer literal `[first, last)` and its prefix length
+inline DigitKernel integer_kernel(const char *first, const char *last,
+                                  size_t &prefix) {
+  prefix = 2;
 
-    result = (result << 1) | (c - '0');
-    valid = true;
+  if (last - first > 2 && first[0] == '0') {
+    // clang-format off
+    switch (first[1] | 0x20) {
+      case 'x': return parse_hex;
+      case 'o': return parse_oct;
+      case 'b': return parse_bin;
+    }
+    // clang-format on
   }
 
-  if (!valid)
-    throw std::invalid_argument("Invalid binary literal: '" + str);
-
-  return result;
+  prefix = 0;
+  return parse_dec;
 }
 
-int64_t parse_integer(const std::string &str) {
-  if (str.empty())
-    throw std::invalid_argument("Invalid argument: empty string");
-
-  std::string log;
-  NumKind kind = numkind(str, log);
-  size_t start = 0;
+inline bool parse_integer_field(const char *first, const char *last,
+                                uint64_t &value) {
+  // the field's length is known, plain decimals go straight to the
+  // kernel for it
+  if (parse_dec_length(first, last - first, value))
+    return true;
 
-  if (kind != NumKind::Decimal)
-    start += 2;
+  size_t prefix;
+  DigitKernel kernel = integer_kernel(first, last, prefix);
 
-  if ((str.length() - start) == 0)
-    throw std::invalid_argument("error, invalid integer");
+  ParseResult<uint64_t> result = kernel(first + prefix, last);
+  bool valid = result && (first + prefix + result.offset == last);
 
-  // clang-format off
-  switch (kind) {
-    case NumKind::Decimal: return parse_dec(start, str, str.length());
-    case NumKind::Hex:     return parse_hex(start, str, str.length());
-    case NumKind::Octal:   return parse_oct(start, str, str.length());
-    case NumKind::Binary:  return parse_bin(start, str, str.length());
-  }
-  // clang-format on
+  value = valid ? result.value : 0;
+  return valid;
 }
 
-long double parse_floating_point(const std::string &str) {
-  if (str.empty())
-    throw std::invalid_argument("Invalid floating point literal: empty string");
+inline bool parse_floating_point_field(const char *first, const char *last,
+                                       double &value) {
+  ParseResult<double> result =
+      float_literal<double>({first, (size_t)(last - first)});
 
-  std::string log;
-  NumKind kind = numkind(str, log);
-  size_t current_character = (kind != NumKind::Decimal) ? 2 : 0;
+  value = result ? result.value : 0;
+  return (bool)result;
+}
 
-  if ((str.length() - current_character) == 0)
-    throw std::invalid_argument("invalid floating point literal: " + str);
+template <typename T, bool (*parse)(const char *, const char *, T &)>
+size_t parse_batch(const char *buffer, const size_t *offsets, size_t count,
+                   T *values, uint8_t *valid) {
+  uint8_t bits = 0;
 
-  else if (kind == NumKind::Octal || kind == NumKind::Binary)
-    throw std::invalid_argument(
-        "float literals must be either Hex or Decimal: " + str);
+  for (size_t i = 0; i < count; ++i) {
+    // start loading the literals ahead while this one is parsed
+    if (i + 8 < count)
+      __builtin_prefetch(buffer + offsets[i + 8]);
 
-  else if (kind == NumKind::Hex ? !std::isxdigit(str.back())
-                                : !std::isdigit(str.back()))
-    throw std::invalid_argument("Invalid floating point end: " + str);
+    bool ok = parse(buffer + offsets[i], buffer + offsets[i + 1], values[i]);
+    bits |= (uint8_t)ok << (i & 7);
 
-  // scientific notation
-  char scientific_notation = (kind == NumKind::Decimal) ? 'e' : 'p';
+    if ((i & 7) == 7) {
+      valid[i >> 3] = bits;
+      bits = 0;
+    }
+  }
 
-  // search for '.'
-  size_t has_dot = str.find('.', current_character);
+  if (count & 7)
+    valid[count >> 3] = bits;
 
-  // search for the scientific notation
-  size_t has_sn = str.find(scientific_notation, current_character);
-  if (has_sn == std::string::npos)
-    has_sn = str.find(toupper(scientific_notation), current_character);
+  return count;
+}
 
-  // if there's more than one
-  if (has_dot != std::string::npos &&
-      str.find('.', has_dot + 1) != std::string::npos)
-    throw std::invalid_argument("Too many '.' in floating point literal: " +
-                                str);
-  if (has_sn != std::string::npos &&
-      (str.find(scientific_notation, has_sn + 1) != std::string::npos ||
-       str.find(toupper(scientific_notation), has_sn + 1) != std::string::npos))
-    throw std::invalid_argument(
-        "Too many scientific notations in floating point literal: " + str);
+// at most `capacity` fields are parsed
+template <typename T, bool (*parse)(const char *, const char *, T &)>
+size_t parse_batch(const char *buffer, size_t length, char delimiter,
+                   T *values, uint8_t *valid, size_t capacity) {
+  const char *p = buffer;
+  const char *last = buffer + length;
 
-  if (has_dot != std::string::npos && has_sn != std::string::npos) {
-    if (has_dot + 1 == has_sn)
-      throw std::invalid_argument("Scientific notation can't come after a '.'");
+  size_t count = 0;
+  uint8_t bits = 0;
 
-    if (has_sn < has_dot)
-      throw std::invalid_argument(
-          "Scientific notation can't be before the '.'");
-  }
+  while (p < last && count < capacity) {
+    const char *end = (const char *)std::memchr(p, delimiter, last - p);
+    if (end == nullptr)
+      end = last;
 
-  uint64_t integer = 0;
-  if (has_dot != 0) {
-    size_t integer_end = std::min(std::min(has_dot, has_sn), str.length());
+    bool ok = parse(p, end, values[count]);
+    bits |= (uint8_t)ok << (count & 7);
 
-    if (kind == NumKind::Decimal)
-      integer = parse_dec(current_character, str, integer_end);
-    else if (kind == NumKind::Hex)
-      integer = parse_hex(current_character, str, integer_end);
+    if ((count & 7) == 7) {
+      valid[count >> 3] = bits;
+      bits = 0;
+    }
 
-    current_character = integer_end;
+    count++;
+    p = end + 1;
   }
-  current_character++;
 
-  if (has_dot == std::string::npos && has_sn == std::string::npos)
-    return integer;
+  if (count & 7)
+    valid[count >> 3] = bits;
 
-  uint64_t fraction = 0;
-  size_t fraction_size = 0;
-  size_t base = (kind == NumKind::Decimal) ? 10 : 16;
-  if (has_dot != std::string::npos) {
-    size_t fraction_end = std::min(has_sn, str.length());
+  return count;
+}
 
-    size_t end = fraction_end;
-    fraction_size = end - current_character;
+size_t parse_integer_batch(const char *buffer, const size_t *offsets,
+                           size_t count, uint64_t *values, uint8_t *valid) {
+  return parse_batch<uint64_t, parse_integer_field>(buffer, offsets, count,
+                                                    values, valid);
+}
 
-    if (fraction_size > FP_FRACTION_MD) {
-      fraction_size = FP_FRACTION_MD;
-      end = fraction_size + current_character;
+// groups of `field_lanes` fields, short decimals all parsed at once by
+// the vector kernel and the others by the scalar parsers
+size_t parse_integer_batch(const char *buffer, size_t length, char delimiter,
+                           uint64_t *values, uint8_t *valid,
+                           size_t capacity) {
+  const char *p = buffer;
+  const char *last = buffer + length;
+  size_t count = 0;
+
+  // after `misses` groups in a row the kernel didn't take, it waits for
+  // 2^misses groups (up to 64) before trying again
+  size_t misses = 0, wait = 0;
+
+  while (fields_kernel && p < last && count + field_lanes <= capacity) {
+    size_t used = wait ? 0 : fields_kernel(p, last, delimiter, values + count);
+    if (used) {
+      std::memset(valid + count / 8, 0xFF, field_lanes / 8);
+      count += field_lanes;
+      p += used;
+      misses = 0;
+      continue;
     }
 
-    if (kind == NumKind::Decimal)
-      fraction = parse_dec(current_character, str, end);
-    else if (kind == NumKind::Hex)
-      fraction = parse_hex(current_character, str, end);
+    wait = wait ? wait - 1 : (size_t)1 << std::min<size_t>(misses++, 6);
 
-    current_character = fraction_end + 1;
-  }
+    uint16_t bits = 0;
+    size_t fields = 0;
 
-  // doesn't have exponent
-  if (current_character >= str.length())
-    return (integer + (fraction / pow(base, fraction_size)));
+    for (; fields < field_lanes && p < last; ++fields) {
+      const char *end = (const char *)std::memchr(p, delimiter, last - p);
+      if (end == nullptr)
+        end = last;
 
-  int64_t exponent = 0;
-  size_t exponent_base = (kind == NumKind::Decimal) ? 10 : 2;
-  size_t len = str.length();
+      bool ok = parse_integer_field(p, end, values[count + fields]);
+      bits |= (uint16_t)ok << fields;
+      p = (end == last) ? last : end + 1;
+    }
 
-  bool negative = false;
-  if (str[current_character] == '-' || str[current_character] == '+') {
-    negative = (str[current_character] == '-');
-    current_character++;
-  }
+    valid[count / 8] = (uint8_t)bits;
+    if (fields > 8)
+      valid[count / 8 + 1] = (uint8_t)(bits >> 8);
 
-  exponent = parse_dec(current_character, str, len);
-  exponent *= (negative) ? -1 : 1;
+    count += fields;
+  }
 
-  long double result =
-      (integer + (fraction / pow(base, fraction_size))) // mantissa
-      * pow(exponent_base, exponent);                   // exponent
+  return count + parse_batch<uint64_t, parse_integer_field>(
+                     p, last - p, delimiter, values + count,
+                     valid + count / 8, capacity - count);
+}
 
-  if (!std::isfinite(result))
-    throw std::out_of_range("floating point literal overflow: " + str);
+size_t parse_floating_point_batch(const char *buffer, const size_t *offsets,
+                                  size_t count, double *values,
+                                  uint8_t *valid) {
+  return parse_batch<double, parse_floating_point_field>(buffer, offsets,
+                                                         count, values, valid);
+}
 
-  return result;
+size_t parse_floating_point_batch(const char *buffer, size_t length,
+                                  char delimiter, double *values,
+                                  uint8_t *valid, size_t capacity) {
+  return parse_batch<double, parse_floating_point_field>(
+      buffer, length, delimiter, values, valid, capacity);
 }
 
-bool valid_integer(std::string str) {
+bool valid_integer(const char *first, const char *last) {
   enum Kind { Decimal, Hex, Octal, Binary };
 
+  std::string_view str(first, last - first);
   if (str.empty() || str.find(' ') != std::string::npos)
     return false;
 
   Kind kind = Decimal;
 
   if (starts_with(str, "-") || starts_with(str, "+"))
-    str.erase(0, 1);
+    str.remove_prefix(1);
 
   if (starts_with(str, "0x") || starts_with(str, "0X")) {
     kind = Hex;
-    str.erase(0, 2);
+    str.remove_prefix(2);
   }
 
   else if (starts_with(str, "0o") || starts_with(str, "0O")) {
     kind = Octal;
-    str.erase(0, 2);
+    str.remove_prefix(2);
   }
 
   else if (starts_with(str, "0b") || starts_with(str, "0B")) {
     kind = Binary;
-    str.erase(0, 2);
+    str.remove_prefix(2);
   }
 
   if (str.length() == 0)
     return false;
 
   for (unsigned char c : str) {
-    if (kind == Hex ? !isxdigit(c) : !isdigit(c))
+    if (kind == Hex ? !is_xdigit(c) : !is_digit(c))
       return false;
 
     if (kind == Octal && (c == '8' || c == '9'))
@@ -358,33 +1818,35 @@ bool valid_integer(std::string str) {
   return true;
 }
 
+bool valid_integer(const std::string &str) {
+  return valid_integer(str.data(), str.data() + str.length());
+}
+
 long double parse_float(const std::string &str) {
   if (str.empty())
-    logger.log(Logger::Level::ERROR,
-               "Invalid floating point literal: " + str + "\n");
+    logger.log<Logger::Level::ERROR>("Invalid floating point literal: {}", str);
 
   std::string log;
   NumKind kind = numkind(str, log);
   size_t current_character = (kind != NumKind::Decimal) ? 2 : 0;
 
   if ((str.length() - current_character) == 0)
-    logger.log(Logger::Level::ERROR,
-               "invalid floating point literal: " + str + "\n");
+    logger.log<Logger::Level::ERROR>("invalid floating point literal: {}", str);
 
   else if (kind == NumKind::Octal || kind == NumKind::Binary)
-    logger.log(Logger::Level::ERROR,
-               "float literals must be either Hex or Decimal: " + str + "\n");
+    logger.log<Logger::Level::ERROR>(
+        "float literals must be either Hex or Decimal: {}", str);
 
-  else if (kind == NumKind::Hex ? !std::isxdigit(str.back())
-                                : !std::isdigit(str.back()))
-    logger.log(Logger::Level::ERROR,
-               "Invalid floating point end: " + str + "\n");
+  else if (kind == NumKind::Hex ? !is_xdigit(str.back())
+                                : !is_digit(str.back()))
+    logger.log<Logger::Level::ERROR>("Invalid floating point end: {}", str);
 
   enum class Section { Integer, Fraction, Exponent };
   Section section = Section::Integer;
 
   // scientific notation
   char scientific_notation = (kind == NumKind::Decimal) ? 'e' : 'p';
+  char scientific_notation_upper = (kind == NumKind::Decimal) ? 'E' : 'P';
 
   // search for '.'
   size_t has_dot = str.find('.', current_character);
@@ -392,93 +1854,79 @@ long double parse_float(const std::string &str) {
   // search for the scientific notation
   size_t has_sn = str.find(scientific_notation, current_character);
   if (has_sn == std::string::npos)
-    has_sn = str.find(toupper(scientific_notation), current_character);
+    has_sn = str.find(scientific_notation_upper, current_character);
 
   // if there's more than one
   if (has_dot != std::string::npos &&
       str.find('.', has_dot + 1) != std::string::npos)
-    logger.log(Logger::Level::ERROR,
-               "Too many '.' in floating point literal: " + str + "\n");
+    logger.log<Logger::Level::ERROR>(
+        "Too many '.' in floating point literal: {}", str);
 
   if (has_sn != std::string::npos &&
       (str.find(scientific_notation, has_sn + 1) != std::string::npos ||
-       str.find(toupper(scientific_notation), has_sn + 1) != std::string::npos))
-    logger.log(Logger::Level::ERROR,
-               "Too many scientific notations in floating point literal: " +
-                   str + "\n");
+       str.find(scientific_notation_upper, has_sn + 1) != std::string::npos))
+    logger.log<Logger::Level::ERROR>(
+        "Too many scientific notations in floating point literal: {}", str);
 
   if (has_dot != std::string::npos && has_sn != std::string::npos) {
     if (has_dot + 1 == has_sn)
-      logger.log(Logger::Level::ERROR,
-                 "Scientific notation can't come after a '.'\n");
+      logger.log<Logger::Level::ERROR>(
+          "Scientific notation can't come after a '.'");
 
     if (has_sn < has_dot)
-      logger.log(Logger::Level::ERROR,
-                 "Scientific notation can't be before the '.'\n");
+      logger.log<Logger::Level::ERROR>(
+          "Scientific notation can't be before the '.'");
   }
 
-  uint64_t integer = 0;
-  if (has_dot != 0) {
-    size_t integer_end = std::min(std::min(has_dot, has_sn), str.length());
-
-    if (kind == NumKind::Decimal)
-      integer = parse_dec(current_character, str, integer_end);
-    else if (kind == NumKind::Hex)
-      integer = parse_hex(current_character, str, integer_end);
-
-    current_character = integer_end;
-  }
-  current_character++;
+  size_t mantissa_end = std::min(has_sn, str.length());
+  const char *first = str.data() + current_character;
+  const char *dot = str.data() + std::min(has_dot, mantissa_end);
+  const char *last = str.data() + mantissa_end;
+  long double result = 0;
+
+  // digit errors still throw
+  auto check = [&](auto section, const char *from) {
+    if (!section) {
+      section.offset += from - str.data();
+      throw_parse_error(section, str.data(), str);
+    }
+    return section.value;
+  };
 
-  if (has_dot == std::string::npos && has_sn == std::string::npos)
-    return integer;
+  if (kind == NumKind::Decimal) {
+    DecimalDigits digits;
 
-  uint64_t fraction = 0;
-  size_t fraction_size = 0;
-  size_t base = (kind == NumKind::Decimal) ? 10 : 16;
-  if (has_dot != std::string::npos) {
-    size_t fraction_end = std::min(has_sn, str.length());
+    if (has_dot != 0)
+      check(gather_dec(first, dot, false, digits), first);
 
-    size_t end = fraction_end;
-    fraction_size = end - current_character;
+    if (has_dot != std::string::npos)
+      check(gather_dec(dot + 1, last, true, digits), dot + 1);
 
-    if (fraction_size > FP_FRACTION_MD) {
-      fraction_size = FP_FRACTION_MD;
-      end = fraction_size + current_character;
-    }
+    int64_t exponent = 0;
+    if (has_sn != std::string::npos)
+      exponent = check(parse_exponent(last + 1, str.data() + str.length()),
+                       last + 1);
 
-    if (kind == NumKind::Decimal)
-      fraction = parse_dec(current_character, str, end);
-    else if (kind == NumKind::Hex)
-      fraction = parse_hex(current_character, str, end);
+    result = decimal_to_float<long double>(digits, first, last, exponent);
+  } else if (kind == NumKind::Hex) {
+    HexDigits digits;
 
-    current_character = fraction_end + 1;
-  }
+    check(gather_hex(first, dot, false, digits), first);
 
-  // doesn't have exponent
-  if (current_character >= str.length())
-    return (integer + (fraction / pow(base, fraction_size)));
+    if (has_dot != std::string::npos)
+      check(gather_hex(dot + 1, last, true, digits), dot + 1);
 
-  int64_t exponent = 0;
-  size_t exponent_base = (kind == NumKind::Decimal) ? 10 : 2;
-  size_t len = str.length();
+    int64_t exponent = 0;
+    if (has_sn != std::string::npos)
+      exponent = check(parse_exponent(last + 1, str.data() + str.length()),
+                       last + 1);
 
-  bool negative = false;
-  if (str[current_character] == '-' || str[current_character] == '+') {
-    negative = (str[current_character] == '-');
-    current_character++;
+    result = hex_to_float<long double>(digits, exponent);
   }
 
-  exponent = parse_dec(current_character, str, len);
-  exponent *= (negative) ? -1 : 1;
-
-  long double result =
-      (integer + (fraction / pow(base, fraction_size))) // mantissa
-      * pow(exponent_base, exponent);                   // exponent
-
   if (!std::isfinite(result))
-    logger.log(Logger::Level::ERROR,
-               "floating point literal overflow: " + str + "\n");
+    logger.log<Logger::Level::ERROR>("floating point literal overflow: {}",
+                                     str);
 
   return result;
 }
@@ -486,14 +1934,15 @@ long double parse_float(const std::string &str) {
 long double parse_float(const std::string &str, std::string &log) {
   enum class Section { Integer, Fraction, Exponent };
 
-  long double integer = 0;
-  long double fraction = 0;
   long double exponent = 0;
 
   size_t fraction_size = 0;
+  DecimalDigits decimal_digits;
+  HexDigits hex_digits;
 
   NumKind kind = numkind(str, log);
-  char scientific_notation = (kind == NumKind::Hex) ? 'p' : 'e';
+  uint8_t scientific_notation =
+      (kind == NumKind::Hex) ? CharClass::HexExponent : CharClass::DecExponent;
   size_t current_character = (kind == NumKind::Hex) ? 2 : 0;
 
   if (kind != NumKind::Decimal && kind != NumKind::Hex)
@@ -505,6 +1954,7 @@ long double parse_float(const std::string &str, std::string &log) {
 
   Section section = Section::Integer;
   size_t section_size = -1;
+  size_t mantissa_end = str.length();
 
   bool negative = false;
   uint64_t tmp = 0;
@@ -517,8 +1967,8 @@ long double parse_float(const std::string &str, std::string &log) {
             "separators are not allowed at the begining of a literal: " + str +
             "\n";
 
-      else if ((kind == NumKind::Hex) ? !std::isxdigit(str[i - 1])
-                                      : !std::isdigit(str[i - 1]))
+      else if ((kind == NumKind::Hex) ? !is_xdigit(str[i - 1])
+                                      : !is_digit(str[i - 1]))
         log += "Only one separator at a time is alowed: " + str + "\n";
 
       continue;
@@ -532,7 +1982,6 @@ long double parse_float(const std::string &str, std::string &log) {
         log += "Invalid float literal, empty sections are not allowed: " + str +
                "\n";
 
-      integer = tmp;
       tmp = 0;
 
       section = Section::Fraction;
@@ -540,7 +1989,7 @@ long double parse_float(const std::string &str, std::string &log) {
       continue;
     }
 
-    if (c == scientific_notation || c == toupper(scientific_notation)) {
+    if (char_class(c) & scientific_notation) {
       if (section == Section::Exponent)
         log += "Invalid Exponent Sections in float literal: " + str + "\n";
 
@@ -552,15 +2001,13 @@ long double parse_float(const std::string &str, std::string &log) {
         log += "Float literals can't end with a scientific notation: " + str +
                "\n";
 
+      mantissa_end = i;
+
       if (str[i + 1] == '-' || str[i + 1] == '+') {
         negative = (str[i + 1] == '-');
         i++;
       }
 
-      // clang-format off
-          if (section == Section::Fraction) fraction = tmp;
-          else integer = tmp;
-      // clang-format on
       tmp = 0;
 
       section = Section::Exponent;
@@ -569,17 +2016,17 @@ long double parse_float(const std::string &str, std::string &log) {
     }
 
     bool found = false;
-    if (section == Section::Exponent && !std::isdigit(c)) {
+    if (section == Section::Exponent && !is_digit(c)) {
       log += "Exponent must be a valid decimal: " + str + "\n";
       found = true;
     }
 
-    if (kind == NumKind::Hex && !std::isxdigit(c)) {
+    if (kind == NumKind::Hex && !is_xdigit(c)) {
       log += "Invalid digit in hex literal: " + str + "\n";
       found = true;
     }
 
-    if (kind == NumKind::Decimal && !std::isdigit(c)) {
+    if (kind == NumKind::Decimal && !is_digit(c)) {
       log += "Invalid digit in decimal literal: " + str + "\n";
       found = true;
     }
@@ -587,24 +2034,28 @@ long double parse_float(const std::string &str, std::string &log) {
     if (found)
       continue;
 
-    size_t digit;
-    if (c >= '0' && c <= '9')
-      digit = c - '0';
-    else if (c >= 'a' && c <= 'f')
-      digit = c - 'a' + 10;
-    else
-      digit = c - 'A' + 10;
+    size_t digit = char_value(c);
+
+    // the digits are kept exactly, they don't need the limit below
+    if (kind == NumKind::Hex && section != Section::Exponent)
+      hex_digits.append(digit, section == Section::Fraction);
 
-    if (tmp > (UINT64_MAX - digit) / (uint64_t)kind)
+    if (kind == NumKind::Decimal && section != Section::Exponent)
+      decimal_digits.append(digit, section == Section::Fraction);
+
+    // the exponent is decimal, even in hex literals
+    uint64_t base = (section == Section::Exponent) ? 10 : (uint64_t)kind;
+
+    if (tmp > (UINT64_MAX - digit) / base)
       log += "float literal overflow: " + str + "\n";
 
-    if (fraction_size >= FP_FRACTION_MD)
+    if (section == Section::Fraction && fraction_size >= FP_FRACTION_MD)
       continue;
 
     if (section == Section::Fraction)
       fraction_size++;
 
-    tmp = (tmp * (uint64_t)kind) + digit;
+    tmp = (tmp * base) + digit;
     section_size++;
   }
 
@@ -612,22 +2063,23 @@ long double parse_float(const std::string &str, std::string &log) {
     log +=
         "Invalid float literal, empty sections are not allowed: " + str + "\n";
 
-  // clang-format off
-      switch (section) {
-        case Section::Integer:  integer = tmp;  break;
-        case Section::Fraction: fraction = tmp; break;
-        case Section::Exponent: exponent = tmp; break;
-      }
-  // clang-format on
+  if (section == Section::Exponent)
+    exponent = tmp;
 
   if (negative)
     exponent *= -1;
 
-  size_t exponent_base = (kind == NumKind::Hex) ? 2 : 10;
+  exponent = std::max(std::min(exponent, 1e7L), -1e7L);
+
+  const char *first = str.data() + current_character;
+  const char *last = str.data() + mantissa_end;
+  long double result;
 
-  long double result =
-      (integer + (fraction / powl((uint64_t)kind, fraction_size))) // mantissa
-      * powl(exponent_base, exponent);                             // exponent
+  if (kind == NumKind::Hex)
+    result = hex_to_float<long double>(hex_digits, (int64_t)exponent);
+  else
+    result = decimal_to_float<long double>(decimal_digits, first, last,
+                                           (int64_t)exponent);
 
   if (!std::isfinite(result))
     log += "float literal overflow: " + str + "\n";
@@ -635,6 +2087,504 @@ long double parse_float(const std::string &str, std::string &log) {
   return result;
 }
 
-int main (int argc, char *argv[]) {
+/*
+ * A numeric literal found by `scan_literals()`, `text` is a view into
+ * the scanned buffer and `offset` its position there.
+ */
+struct Literal {
+  size_t offset;
+  NumKind kind;
+  bool floating;
+  std::string_view text;
+  uint64_t integer; // value if !floating
+  long double real; // value if floating
+};
+
+/*
+ * Rest of the preprocessing number going on at `p` after its `previous`
+ * character: digits, letters, '_', '.', separators followed by one of
+ * those and a sign right after an exponent marker. When the input is
+ * `split` past `last`, a separator ending it is kept since its digit
+ * may come next.
+ */
+const char *pp_number_rest(const char *p, const char *last,
+                           unsigned char previous, bool split = false) {
+  while (p < last) {
+    unsigned char c = *p;
+
+    if (is_identifier(c) || c == '.' ||
+        (c == '\'' && (p + 1 < last ? is_identifier(p[1]) : split))) {
+      previous = c;
+      p++;
+      continue;
+    }
+
+    if ((c == '+' || c == '-') &&
+        ((previous | 0x20) == 'e' || (previous | 0x20) == 'p')) {
+      previous = c;
+      p++;
+      continue;
+    }
+
+    break;
+  }
+
+  return p;
+}
+
+/*
+ * End of the preprocessing number at `p`. It's what a C/C++ lexer cuts
+ * before validation.
+ */
+const char *pp_number_end(const char *p, const char *last) {
+  return pp_number_rest(p + 1, last, *p);
+}
+
+/*
+ * End of the string/character literal or comment starting at `p`,
+ * `p` itself if there's none.
+ */
+const char *skip_non_code(const char *p, const char *last) {
+  char c = *p;
+
+  if (c == '"' || c == '\'') {
+    for (++p; p < last && *p != c && *p != '\n'; ++p)
+      if (*p == '\\')
+        p++;
+
+    return (p < last) ? p + 1 : last;
+  }
+
+  if (c == '/' && p + 1 < last && p[1] == '/') {
+    const char *end = (const char *)std::memchr(p, '\n', last - p);
+    return end ? end : last;
+  }
+
+  if (c == '/' && p + 1 < last && p[1] == '*') {
+    for (p += 2; p + 1 < last; ++p)
+      if (p[0] == '*' && p[1] == '/')
+        return p + 2;
+
+    return last;
+  }
+
+  return p;
+}
+
+/*
+ * Fill `literal` if `text` is a literal the validators accept and its
+ * value fits, integers have no '.' nor exponent and are C octal after
+ * a leading 0.
+ */
+bool scan_literal(std::string_view text, Literal &literal) {
+  NumKind kind = numkind(text);
+  bool valid = false;
+
+  // clang-format off
+  switch (kind) {
+    case NumKind::Decimal: valid = validate_dec(text); break;
+    case NumKind::Hex:     valid = validate_hex(text); break;
+    case NumKind::Octal:   valid = validate_oct(text); break;
+    case NumKind::Binary:  valid = validate_bin(text); break;
+  }
+  // clang-format on
+
+  if (!valid)
+    return false;
+
+  literal.kind = kind;
+  literal.text = text;
+  literal.floating = is_float_literal(text);
+
+  if (literal.floating) {
+    ParseResult<long double> result = float_literal<long double>(text);
+    literal.integer = 0;
+    literal.real = result.value;
+    return (bool)result;
+  }
+
+  literal.real = 0;
+
+  // C reads digits after a leading 0 as octal, 017 is 15 and 08 isn't
+  // a literal
+  if (kind == NumKind::Decimal && text.length() > 1 && text[0] == '0') {
+    ParseResult<uint64_t> result =
+        parse_oct(text.data() + 1, text.data() + text.length());
+    literal.kind = NumKind::Octal;
+    literal.integer = result.value;
+    return result && result.offset + 1 == text.length();
+  }
+
+  ParseResult<int64_t> result =
+      parse_integer(text.data(), text.data() + text.length());
+  literal.integer = (uint64_t)result.value;
+  return result && result.offset == text.length();
+}
+
+/*
+ * Call `callback(const Literal &)` for every numeric literal starting in
+ * `[start, stop)` of the C/C++ like `source`, strings, character
+ * literals and comments are skipped. `start` is taken to be in code,
+ * the tokens starting before `stop` are followed to their end. Returns
+ * the offset the scan stopped at, `stop` unless a token (a comment, a
+ * string) runs over it.
+ */
+template <typename Callback>
+size_t scan_literals(std::string_view source, size_t start, size_t stop,
+                     Callback callback) {
+  const char *first = source.data();
+  const char *last = first + source.length();
+  const char *p = first + start;
+
+  Literal literal;
+
+  while (p < first + stop) {
+    unsigned char c = *p;
+
+    if (is_digit(c) || (c == '.' && p + 1 < last && is_digit(p[1]))) {
+      const char *end = pp_number_end(p, last);
+
+      if (scan_literal({p, (size_t)(end - p)}, literal)) {
+        literal.offset = p - first;
+        callback(literal);
+      }
+
+      p = end;
+    } else if (is_identifier(c)) {
+      while (p < last && is_identifier(*p))
+        p++;
+    } else {
+      const char *end = skip_non_code(p, last);
+      p = (end == p) ? p + 1 : end;
+    }
+  }
+
+  return std::max(p, first + start) - first;
+}
+
+// the whole `source`, returns the number of literals
+template <typename Callback>
+size_t scan_literals(std::string_view source, Callback callback) {
+  size_t count = 0;
+
+  scan_literals(source, 0, source.length(), [&](const Literal &literal) {
+    callback(literal);
+    count++;
+  });
+
+  return count;
+}
+
+/*
+ * Chunk indices of one worker, the owner takes them from the front and
+ * idle workers steal from the back.
+ */
+class WorkQueue {
+public:
+  void push(size_t chunk) { chunks.push_back(chunk); }
+
+  bool pop(size_t &chunk) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (chunks.empty())
+      return false;
+
+    chunk = chunks.front();
+    chunks.pop_front();
+    return true;
+  }
+
+  bool steal(size_t &chunk) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (chunks.empty())
+      return false;
+
+    chunk = chunks.back();
+    chunks.pop_back();
+    return true;
+  }
+
+private:
+  std::mutex mutex;
+  std::deque<size_t> chunks;
+};
+
+/*
+ * `scan_literals()` over `threads` workers. `source` is cut in chunks of
+ * about `chunk_size` bytes, each ending after a newline so no literal
+ * (nor a line comment) is split. Each chunk is scanned as if it started
+ * in code; when the scan of the previous one ends past the cut instead
+ * (a block comment or a string spanning it), the chunk is scanned again
+ * from there, so the literals are those of the sequential scan. Returns
+ * them in input order.
+ */
+std::vector<Literal> scan_literals_parallel(std::string_view source,
+                                            unsigned threads,
+                                            size_t chunk_size = 1 << 20) {
+  const char *first = source.data();
+  const char *last = first + source.length();
+
+  std::vector<size_t> bounds{0};
+  for (const char *p = first; p < last;) {
+    const char *end = p + std::min<size_t>(chunk_size, last - p);
+
+    if (end < last) {
+      end = (const char *)std::memchr(end, '\n', last - end);
+      end = end ? end + 1 : last;
+    }
+
+    bounds.push_back(end - first);
+    p = end;
+  }
+
+  size_t chunks = bounds.size() - 1;
+  threads = std::max(1u, std::min<unsigned>(threads, chunks));
+
+  // contiguous runs of chunks per worker, stealing balances the rest
+  std::vector<WorkQueue> queues(threads);
+  for (size_t i = 0; i < chunks; ++i)
+    queues[i * threads / chunks].push(i);
+
+  std::vector<std::vector<Literal>> results(chunks);
+  std::vector<size_t> stops(chunks);
+
+  auto worker = [&](unsigned id) {
+    size_t chunk;
+
+    for (;;) {
+      bool found = queues[id].pop(chunk);
+      for (unsigned i = 1; !found && i < threads; ++i)
+        found = queues[(id + i) % threads].steal(chunk);
+
+      // no worker adds chunks, so empty queues stay empty
+      if (!found)
+        break;
+
+      std::vector<Literal> &out = results[chunk];
+      stops[chunk] = scan_literals(
+          source, bounds[chunk], bounds[chunk + 1],
+          [&](const Literal &literal) { out.push_back(literal); });
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned id = 1; id < threads; ++id)
+    pool.emplace_back(worker, id);
+
+  worker(0);
+  for (std::thread &thread : pool)
+    thread.join();
+
+  // chunks whose start the sequential scan didn't reach in code
+  for (size_t i = 1; i < chunks; ++i) {
+    if (stops[i - 1] == bounds[i])
+      continue;
+
+    std::vector<Literal> &out = results[i];
+    out.clear();
+    stops[i] = scan_literals(
+        source, stops[i - 1], bounds[i + 1],
+        [&](const Literal &literal) { out.push_back(literal); });
+  }
+
+  size_t total = 0;
+  for (const std::vector<Literal> &result : results)
+    total += result.size();
+
+  std::vector<Literal> literals;
+  literals.reserve(total);
+  for (const std::vector<Literal> &result : results)
+    literals.insert(literals.end(), result.begin(), result.end());
+
+  return literals;
+}
+
+/*
+ * Push parser for literals read in chunks, from a socket or a pipe.
+ * The stream is cut like `scan_literals()` cuts source code, minus the
+ * strings and comments: preprocessing numbers, identifiers (skipped)
+ * and anything else in between. Every number goes to `parse` and
+ * `emit(offset, text, result)` is called with its offset in the
+ * stream, `text` only lives for the call. A number `parse` doesn't
+ * take whole is an InvalidDigit.
+ *
+ * The numbers complete in a chunk are parsed in place. Only the bytes
+ * of the one running past its end are kept, with what the lexer needs
+ * to resume (an exponent marker before a sign, a trailing separator or
+ * '.', an identifier going on), until the chunk completing it.
+ */
+template <typename T, ParseResult<T> (*parse)(const char *, const char *)>
+class PushParser {
+public:
+  using Callback =
+      std::function<void(size_t, std::string_view, const ParseResult<T> &)>;
+
+  explicit PushParser(Callback callback) : emit(std::move(callback)) {}
+
+  // the next `length` bytes of the stream
+  void feed(const char *data, size_t length) {
+    if (length == 0)
+      return;
+
+    const char *p = data;
+    const char *last = data + length;
+
+    if (!pending.empty())
+      p = resume(p, last);
+    else if (is_identifier(previous))
+      while (p < last && is_identifier(*p))
+        p++;
+
+    while (p < last) {
+      unsigned char c = *p;
+
+      if (is_digit(c) || c == '.') {
+        // a '.' starts a number if a digit follows, maybe in the next chunk
+        if (c == '.' && p + 1 < last && !is_digit(p[1])) {
+          p++;
+          continue;
+        }
+
+        const char *end = pp_number_rest(p + 1, last, c, true);
+        if (end == last) {
+          pending.assign(p, last);
+          pending_offset = position + (p - data);
+          break;
+        }
+
+        number(position + (p - data), p, end);
+        p = end;
+      } else if (is_identifier(c)) {
+        while (p < last && is_identifier(*p))
+          p++;
+      } else {
+        p++;
+      }
+    }
+
+    previous = last[-1];
+    position += length;
+  }
+
+  // end of the stream, the number it ends with is complete
+  void finish() {
+    if (pending.length() > 1 && pending.back() == '\'')
+      pending.pop_back();
+
+    if (pending != "." && !pending.empty())
+      number(pending_offset, pending.data(), pending.data() + pending.size());
+
+    pending.clear();
+    previous = 0;
+  }
+
+  // bytes fed so far
+  size_t offset() const { return position; }
+
+private:
+  // the number in `pending` goes on at `p`
+  const char *resume(const char *p, const char *last) {
+    unsigned char next = *p;
+
+    // the '.' wasn't the start of a number, nor the separator part of it
+    if (pending == "." && !is_digit(next)) {
+      pending.clear();
+      return p;
+    }
+
+    if (pending.back() == '\'' && !is_identifier(next)) {
+      pending.pop_back();
+      flush();
+      return p;
+    }
+
+    const char *end = pp_number_rest(p, last, pending.back(), true);
+    pending.append(p, end);
+
+    if (end < last)
+      flush();
+    return end;
+  }
+
+  void flush() {
+    number(pending_offset, pending.data(), pending.data() + pending.size());
+    pending.clear();
+  }
+
+  void number(size_t at, const char *first, const char *last) {
+    ParseResult<T> result = parse(first, last);
+    if (result && first + result.offset != last)
+      result.error = ParseError::InvalidDigit;
+
+    emit(at, {first, (size_t)(last - first)}, result);
+  }
+
+  Callback emit;
+  std::string pending; // the number split by the end of the last chunk
+  size_t pending_offset = 0;
+  size_t position = 0;
+  unsigned char previous = 0; // last byte fed
+};
+
+using IntegerPushParser = PushParser<int64_t, parse_integer>;
+using FloatingPointPushParser = PushParser<long double, parse_floating_point>;
+
+// bench.cpp brings its own main()
+#ifndef NPARSER_NO_MAIN
+int main(int argc, char *argv[]) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+  if (argc == 4 && std::string(argv[1]) == "-j") {
+    threads = std::max(1, std::atoi(argv[2]));
+    argv += 2;
+    argc -= 2;
+  }
+
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " [-j threads] <file>\n";
+    return 1;
+  }
+
+  try {
+    MappedFile file(argv[1]);
+    std::string_view source = file.view();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Literal> literals = scan_literals_parallel(source, threads);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::ios::sync_with_stdio(false);
+    std::cout << std::setprecision(
+        std::numeric_limits<long double>::max_digits10);
+
+    for (const Literal &literal : literals) {
+      const char *kind = "decimal";
+
+      // clang-format off
+      switch (literal.kind) {
+        case NumKind::Decimal: kind = "decimal"; break;
+        case NumKind::Hex:     kind = "hex";     break;
+        case NumKind::Octal:   kind = "octal";   break;
+        case NumKind::Binary:  kind = "binary";  break;
+      }
+      // clang-format on
+
+      std::cout << literal.offset << ' ' << kind << ' ';
+      if (literal.floating)
+        std::cout << literal.real << '\n';
+      else
+        std::cout << literal.integer << '\n';
+    }
+
+    std::cerr << literals.size() << " literals in " << source.length()
+              << " bytes, " << std::fixed << std::setprecision(3)
+              << (source.length() / elapsed.count() / 1e9) << " GB/s on "
+              << threads << " threads\n";
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
   return 0;
 }
+#endif
@@ -0,0 +1,508 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "charclass.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Vector digit kernels, picked at runtime from what the CPU supports.
+ *
+ * A kernel parses the digits at the start of `[first, last)` and
+ * returns how many characters it used, or 0 when the scalar loop has
+ * to take over: separators, too many digits, invalid or too short
+ * input. The kernel pointers are null without a vector unit for them.
+ */
+using VectorKernel = size_t (*)(const char *first, const char *last,
+                                uint64_t &value);
+
+// true if the scalar loop wouldn't go on after `length` characters
+inline bool digits_end(const char *first, size_t length, size_t available,
+                       unsigned base) {
+  return length != 0 &&
+         (length == available ||
+          (char_value(first[length]) >= base && first[length] != '\''));
+}
+
+constexpr uint64_t reverse_bits(uint64_t x) {
+  x = ((x >> 1) & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+  x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+  x = ((x >> 4) & 0x0F0F0F0F0F0F0F0F) | ((x & 0x0F0F0F0F0F0F0F0F) << 4);
+  return __builtin_bswap64(x);
+}
+
+/*
+ * Binary digits from the masks of the first (up to) 64 characters, bit
+ * `i` for character `i`: the digits end at the first invalid character
+ * and the first digit is the most significant bit.
+ */
+inline size_t binary_digits(const char *first, size_t available,
+                            uint64_t valid, uint64_t ones, uint64_t &value) {
+  size_t length = ~valid ? __builtin_ctzll(~valid) : 64;
+  if (!digits_end(first, length, available, 2))
+    return 0;
+
+  value = reverse_bits(ones) >> (64 - length);
+  return length;
+}
+
+/*
+ * Separator stripping, so separated literals can take the kernels:
+ * returns the separators in the first `window` (at most 64) characters
+ * as a mask, bit `i` for character `i`. When there are some, the other
+ * characters are copied to `digits` and padded with 0 to 64 bytes (it
+ * needs room for 72).
+ */
+using StripKernel = uint64_t (*)(const char *first, size_t window,
+                                 char *digits);
+
+inline uint64_t strip_separators(const char *first, size_t window,
+                                 char *digits) {
+  if (!std::memchr(first, '\'', window))
+    return 0;
+
+  uint64_t separators = 0;
+  for (size_t i = 0; i < window; ++i) {
+    if (first[i] == '\'')
+      separators |= 1ull << i;
+    else
+      *digits++ = first[i];
+  }
+
+  std::memset(digits, 0, 64 - window + __builtin_popcountll(separators));
+  return separators;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// `pcmpeqb` finds the separators, `pext` compacts 8 characters at once
+__attribute__((target("sse2,bmi2,popcnt"))) inline uint64_t
+strip_separators_bmi2(const char *first, size_t window, char *digits) {
+  alignas(16) char chars[64] = {};
+  std::memcpy(chars, first, window);
+
+  uint64_t separators = 0;
+  for (size_t block = 0; block < 64; block += 16) {
+    __m128i v = _mm_load_si128((const __m128i *)(chars + block));
+    __m128i separator = _mm_cmpeq_epi8(v, _mm_set1_epi8('\''));
+    separators |= (uint64_t)(uint16_t)_mm_movemask_epi8(separator) << block;
+  }
+
+  if (!separators)
+    return 0;
+
+  for (size_t i = 0; i < 64; i += 8) {
+    uint64_t keep = ~(separators >> i) & 0xFF;
+
+    uint64_t bytes;
+    std::memcpy(&bytes, chars + i, 8);
+    bytes = _pext_u64(bytes, _pdep_u64(keep, 0x0101010101010101) * 0xFF);
+    std::memcpy(digits, &bytes, 8);
+
+    digits += __builtin_popcountll(keep);
+  }
+
+  std::memset(digits, 0, __builtin_popcountll(separators));
+  return separators;
+}
+
+// a masked load, one compare and one `vpcompressb` for 64 characters
+__attribute__((target("avx512bw,avx512vbmi2"))) inline uint64_t
+strip_separators_vbmi2(const char *first, size_t window, char *digits) {
+  __mmask64 in_window = (window < 64) ? (1ull << window) - 1 : ~0ull;
+  __m512i v = _mm512_maskz_loadu_epi8(in_window, first);
+
+  uint64_t separators = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\''));
+  if (!separators)
+    return 0;
+
+  __m512i kept = _mm512_maskz_compress_epi8(~separators, v);
+  _mm512_storeu_si512((void *)digits, kept);
+  return separators;
+}
+
+/*
+ * Hex digits with SSSE3/AVX2: `pshufb` on the high nibble of each
+ * character gives the offset to its value and the range the value must
+ * be in ('0'-'9', 'A'-'F', 'a'-'f'), `pmaddubsw` and `packuswb` then
+ * pack the 16 nibbles into 8 bytes.
+ */
+
+// loaded from index `length`, moves `length` bytes to the end, zeros in
+// front
+constexpr int8_t shift_window[32] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15};
+
+__attribute__((target("ssse3"))) inline __m128i
+hex_nibbles(__m128i chars, uint32_t &valid) {
+  const __m128i offsets = _mm_setr_epi8(0, 0, 0, -0x30, -0x37, 0, -0x57, 0,
+                                        0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i lower = _mm_setr_epi8(-1, -1, -1, 0, 10, -1, 10, -1, -1, -1,
+                                      -1, -1, -1, -1, -1, -1);
+  const __m128i upper = _mm_setr_epi8(0, 0, 0, 9, 15, 0, 15, 0, 0, 0, 0, 0, 0,
+                                      0, 0, 0);
+
+  __m128i high = _mm_and_si128(_mm_srli_epi16(chars, 4), _mm_set1_epi8(0x0F));
+  __m128i nibbles = _mm_add_epi8(chars, _mm_shuffle_epi8(offsets, high));
+
+  __m128i above = _mm_cmpeq_epi8(
+      _mm_max_epu8(nibbles, _mm_shuffle_epi8(lower, high)), nibbles);
+  __m128i below = _mm_cmpeq_epi8(
+      _mm_min_epu8(nibbles, _mm_shuffle_epi8(upper, high)), nibbles);
+
+  valid = (uint32_t)_mm_movemask_epi8(_mm_and_si128(above, below));
+  return nibbles;
+}
+
+// the first character is the most significant nibble
+__attribute__((target("ssse3"))) inline uint64_t pack_nibbles(__m128i nibbles) {
+  __m128i bytes = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+  bytes = _mm_packus_epi16(bytes, bytes);
+
+  uint64_t packed;
+  _mm_storel_epi64((__m128i *)&packed, bytes);
+  return __builtin_bswap64(packed);
+}
+
+__attribute__((target("ssse3"))) inline size_t
+parse_hex_ssse3(const char *first, const char *last, uint64_t &value) {
+  size_t available = last - first;
+  if (available < 16)
+    return 0;
+
+  uint32_t valid;
+  __m128i nibbles =
+      hex_nibbles(_mm_loadu_si128((const __m128i *)first), valid);
+
+  size_t length = __builtin_ctz(~valid);
+  if (!digits_end(first, length, available, 16))
+    return 0;
+
+  __m128i window = _mm_loadu_si128((const __m128i *)(shift_window + length));
+  value = pack_nibbles(_mm_shuffle_epi8(nibbles, window));
+  return length;
+}
+
+__attribute__((target("avx2"))) inline __m256i hex_nibbles(__m256i chars,
+                                                          uint32_t &valid) {
+  const __m256i offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      0, 0, 0, -0x30, -0x37, 0, -0x57, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+  const __m256i lower = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      -1, -1, -1, 0, 10, -1, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+  const __m256i upper = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(0, 0, 0, 9, 15, 0, 15, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+
+  __m256i high =
+      _mm256_and_si256(_mm256_srli_epi16(chars, 4), _mm256_set1_epi8(0x0F));
+  __m256i nibbles = _mm256_add_epi8(chars, _mm256_shuffle_epi8(offsets, high));
+
+  __m256i above = _mm256_cmpeq_epi8(
+      _mm256_max_epu8(nibbles, _mm256_shuffle_epi8(lower, high)), nibbles);
+  __m256i below = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(nibbles, _mm256_shuffle_epi8(upper, high)), nibbles);
+
+  valid = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(above, below));
+  return nibbles;
+}
+
+/*
+ * 32 characters at once, so up to 32 digits are validated; more than
+ * 16 fit only when the extra ones are leading zeros.
+ */
+__attribute__((target("avx2"))) inline size_t
+parse_hex_avx2(const char *first, const char *last, uint64_t &value) {
+  size_t available = last - first;
+  if (available < 32)
+    return parse_hex_ssse3(first, last, value);
+
+  uint32_t valid;
+  __m256i nibbles =
+      hex_nibbles(_mm256_loadu_si256((const __m256i *)first), valid);
+
+  size_t length = __builtin_ctzll(~(uint64_t)valid);
+  if (!digits_end(first, length, available, 16))
+    return 0;
+
+  if (length <= 16) {
+    __m128i window =
+        _mm_loadu_si128((const __m128i *)(shift_window + length));
+    value = pack_nibbles(
+        _mm_shuffle_epi8(_mm256_castsi256_si128(nibbles), window));
+    return length;
+  }
+
+  // overflows, the scalar loop reports it
+  uint32_t zeros = (uint32_t)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(nibbles, _mm256_setzero_si256()));
+  uint32_t leading = (1u << (length - 16)) - 1;
+  if ((zeros & leading) != leading)
+    return 0;
+
+  alignas(32) uint8_t buffer[32];
+  _mm256_store_si256((__m256i *)buffer, nibbles);
+  value = pack_nibbles(
+      _mm_loadu_si128((const __m128i *)(buffer + length - 16)));
+  return length;
+}
+
+/*
+ * Binary digits with `pcmpeqb` against '0' and '1' and `pmovmskb`, 16,
+ * 32 or 64 characters per compare, so a 64-digit literal takes a few
+ * blocks instead of 64 iterations.
+ */
+
+__attribute__((target("sse2"))) inline size_t
+parse_bin_sse2(const char *first, const char *last, uint64_t &value) {
+  size_t available = last - first;
+  uint64_t valid = 0, ones = 0;
+
+  for (size_t block = 0; block < 64 && available - block >= 16; block += 16) {
+    __m128i chars = _mm_loadu_si128((const __m128i *)(first + block));
+    __m128i one = _mm_cmpeq_epi8(chars, _mm_set1_epi8('1'));
+    __m128i digit =
+        _mm_or_si128(one, _mm_cmpeq_epi8(chars, _mm_set1_epi8('0')));
+
+    uint64_t block_valid = (uint16_t)_mm_movemask_epi8(digit);
+    valid |= block_valid << block;
+    ones |= (uint64_t)(uint16_t)_mm_movemask_epi8(one) << block;
+
+    if (block_valid != 0xFFFF)
+      break;
+  }
+
+  return binary_digits(first, available, valid, ones, value);
+}
+
+__attribute__((target("avx2"))) inline size_t
+parse_bin_avx2(const char *first, const char *last, uint64_t &value) {
+  size_t available = last - first;
+  if (available < 32)
+    return parse_bin_sse2(first, last, value);
+
+  uint64_t valid = 0, ones = 0;
+
+  for (size_t block = 0; block < 64 && available - block >= 32; block += 32) {
+    __m256i chars = _mm256_loadu_si256((const __m256i *)(first + block));
+    __m256i one = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('1'));
+    __m256i digit =
+        _mm256_or_si256(one, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('0')));
+
+    uint64_t block_valid = (uint32_t)_mm256_movemask_epi8(digit);
+    valid |= block_valid << block;
+    ones |= (uint64_t)(uint32_t)_mm256_movemask_epi8(one) << block;
+
+    if (block_valid != 0xFFFFFFFF)
+      break;
+  }
+
+  return binary_digits(first, available, valid, ones, value);
+}
+
+__attribute__((target("avx512bw"))) inline size_t
+parse_bin_avx512(const char *first, const char *last, uint64_t &value) {
+  size_t available = last - first;
+  if (available < 64)
+    return parse_bin_avx2(first, last, value);
+
+  __m512i chars = _mm512_loadu_si512((const void *)first);
+  uint64_t ones = _mm512_cmpeq_epi8_mask(chars, _mm512_set1_epi8('1'));
+  uint64_t valid = ones | _mm512_cmpeq_epi8_mask(chars, _mm512_set1_epi8('0'));
+
+  return binary_digits(first, available, valid, ones, value);
+}
+
+#endif
+
+inline VectorKernel select_hex_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return parse_hex_avx2;
+  if (__builtin_cpu_supports("ssse3"))
+    return parse_hex_ssse3;
+#endif
+  return nullptr;
+}
+
+inline const VectorKernel hex_kernel = select_hex_kernel();
+
+inline VectorKernel select_bin_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw"))
+    return parse_bin_avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return parse_bin_avx2;
+  if (__builtin_cpu_supports("sse2"))
+    return parse_bin_sse2;
+#endif
+  return nullptr;
+}
+
+inline const VectorKernel bin_kernel = select_bin_kernel();
+
+inline StripKernel select_strip_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512vbmi2"))
+    return strip_separators_vbmi2;
+  if (__builtin_cpu_supports("bmi2"))
+    return strip_separators_bmi2;
+#endif
+  return strip_separators;
+}
+
+inline const StripKernel strip_kernel = select_strip_kernel();
+
+/*
+ * Short field kernels, for columns of small decimals: parse the next
+ * `field_lanes` fields of `[first, last)`, each 1 to 8 digits followed
+ * by `delimiter`, into `values` and return the characters used (past
+ * the last delimiter). Anything else (an empty or longer field, a
+ * separator, prefix or sign, the end of the input) returns 0 and the
+ * scalar parsers, which know the whole grammar, take the fields.
+ */
+using FieldsKernel = size_t (*)(const char *first, const char *last,
+                                char delimiter, uint64_t *values);
+
+constexpr size_t field_lanes = 16;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/*
+ * Find and check the fields, each one's digits go right aligned in its
+ * 8-byte lane as values 0-9, with 0 in front: the lanes are the digits
+ * transposed for the multiply-adds.
+ */
+__attribute__((target("sse2"))) inline size_t
+split_fields(const char *first, const char *last, char delimiter,
+             uint64_t *digits) {
+  const __m128i delimiters = _mm_set1_epi8(delimiter);
+  const uint64_t zeros = 0x3030303030303030;
+
+  const char *p = first;
+  for (size_t i = 0; i < field_lanes; ++i) {
+    if (last - p < 16)
+      return 0;
+
+    __m128i chars = _mm_loadu_si128((const __m128i *)p);
+    unsigned ends = _mm_movemask_epi8(_mm_cmpeq_epi8(chars, delimiters));
+    size_t length = __builtin_ctz(ends | 0x10000);
+    if (length - 1 >= 8)
+      return 0;
+
+    // little-endian, the first character is the low byte
+    uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+
+    size_t pad = 8 * (8 - length);
+    if (pad)
+      chunk = (chunk << pad) | (zeros >> (64 - pad));
+
+    // all '0' to '9'
+    if (((chunk + 0x4646464646464646) | (chunk - zeros)) & 0x8080808080808080)
+      return 0;
+
+    digits[i] = chunk - zeros;
+    p += length + 1;
+  }
+
+  return p - first;
+}
+
+/*
+ * Lanes of 8 digits to values, 4 lanes per register: pmaddubsw makes
+ * pairs, pmaddwd groups of 4, packusdw and a pmaddwd the 8-digit
+ * values, 32 bits each, then widened to 64.
+ */
+__attribute__((target("avx2"))) inline size_t
+parse_fields_avx2(const char *first, const char *last, char delimiter,
+                  uint64_t *values) {
+  alignas(32) uint64_t digits[field_lanes];
+
+  size_t used = split_fields(first, last, delimiter, digits);
+  if (used == 0)
+    return 0;
+
+  const __m256i tens = _mm256_set1_epi16(0x010A);        // 10, 1
+  const __m256i hundreds = _mm256_set1_epi32(0x00010064); // 100, 1
+  const __m256i myriads = _mm256_set1_epi32(0x00012710);  // 10000, 1
+  const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+  for (size_t i = 0; i < field_lanes; i += 8) {
+    __m256i low = _mm256_load_si256((const __m256i *)(digits + i));
+    __m256i high = _mm256_load_si256((const __m256i *)(digits + i + 4));
+
+    low = _mm256_madd_epi16(_mm256_maddubs_epi16(low, tens), hundreds);
+    high = _mm256_madd_epi16(_mm256_maddubs_epi16(high, tens), hundreds);
+
+    // packusdw interleaves the 128-bit lanes, the permute undoes it
+    __m256i packed = _mm256_packus_epi32(low, high);
+    __m256i result = _mm256_madd_epi16(packed, myriads);
+    result = _mm256_permutevar8x32_epi32(result, order);
+
+    _mm256_storeu_si256((__m256i *)(values + i),
+                        _mm256_cvtepu32_epi64(_mm256_castsi256_si128(result)));
+    _mm256_storeu_si256(
+        (__m256i *)(values + i + 4),
+        _mm256_cvtepu32_epi64(_mm256_extracti128_si256(result, 1)));
+  }
+
+  return used;
+}
+
+// the same with 8 lanes per register, all 16 fields at once
+__attribute__((target("avx512bw"))) inline size_t
+parse_fields_avx512(const char *first, const char *last, char delimiter,
+                    uint64_t *values) {
+  alignas(64) uint64_t digits[field_lanes];
+
+  size_t used = split_fields(first, last, delimiter, digits);
+  if (used == 0)
+    return 0;
+
+  const __m512i tens = _mm512_set1_epi16(0x010A);
+  const __m512i hundreds = _mm512_set1_epi32(0x00010064);
+  const __m512i myriads = _mm512_set1_epi32(0x00012710);
+  const __m512i order = _mm512_setr_epi32(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6,
+                                          7, 10, 11, 14, 15);
+
+  __m512i low = _mm512_load_si512((const void *)digits);
+  __m512i high = _mm512_load_si512((const void *)(digits + 8));
+
+  low = _mm512_madd_epi16(_mm512_maddubs_epi16(low, tens), hundreds);
+  high = _mm512_madd_epi16(_mm512_maddubs_epi16(high, tens), hundreds);
+
+  __m512i packed = _mm512_packus_epi32(low, high);
+  __m512i result = _mm512_madd_epi16(packed, myriads);
+  result = _mm512_permutexvar_epi32(order, result);
+
+  _mm512_storeu_si512((void *)values,
+                      _mm512_cvtepu32_epi64(_mm512_castsi512_si256(result)));
+  _mm512_storeu_si512(
+      (void *)(values + 8),
+      _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(result, 1)));
+
+  return used;
+}
+
+#endif
+
+inline FieldsKernel select_fields_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw"))
+    return parse_fields_avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return parse_fields_avx2;
+#endif
+  return nullptr;
+}
+
+inline const FieldsKernel fields_kernel = select_fields_kernel();
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "charclass.hpp"
+
+constexpr bool starts_with(std::string_view str, std::string_view cmp) {
+  return (str.compare(0, cmp.length(), cmp) == 0);
+}
+
+/*
+ * The validators are a single DFA generated at compile time from the
+ * literal grammars, each one a start state:
+ *
+ *   dec: <digits>[.<digits>][e/E[sign]<digits>]
+ *   hex: 0x/0X<xdigits>[.<xdigits>][p/P[sign]<digits>]
+ *   oct: 0o/0O then octal digits and separators
+ *   bin: 0b/0B then binary digits and separators
+ *
+ * Every float section needs a digit and a separator can follow any
+ * character but another separator (and the start of a decimal).
+ */
+enum class Grammar : uint8_t { Dec, Hex, Oct, Bin };
+
+struct ValidatorDfa {
+  // what the grammars tell apart, 'b' and 'e' are also hex digits
+  enum Class : uint8_t {
+    Other,
+    Zero,
+    One,
+    Octal,     // 2-7
+    Decimal,   // 8, 9
+    HexLetter, // a-f, A-F but b, B, e, E
+    LetterB,
+    LetterE,
+    LetterO,
+    LetterP,
+    LetterX,
+    Dot,
+    Separator,
+    Sign,
+    Classes,
+  };
+
+  static constexpr uint8_t Reject = 0;
+  static constexpr size_t States = 40;
+
+  std::array<uint8_t, 256> classes{};
+  std::array<std::array<uint8_t, Classes>, States> next{};
+  std::array<bool, States> accepting{};
+  std::array<uint8_t, 4> start{};
+};
+
+constexpr bool is_digit_class(uint8_t cls, unsigned base) {
+  switch (cls) {
+  case ValidatorDfa::Zero:
+  case ValidatorDfa::One:
+    return true;
+  case ValidatorDfa::Octal:
+    return base >= 8;
+  case ValidatorDfa::Decimal:
+    return base >= 10;
+  case ValidatorDfa::HexLetter:
+  case ValidatorDfa::LetterB:
+  case ValidatorDfa::LetterE:
+    return base >= 16;
+  default:
+    return false;
+  }
+}
+
+constexpr ValidatorDfa make_validator_dfa() {
+  using Dfa = ValidatorDfa;
+  Dfa dfa;
+
+  for (int c = 0; c < 256; ++c) {
+    uint8_t value = char_value(c);
+
+    if (value < 2)
+      dfa.classes[c] = (value == 0) ? Dfa::Zero : Dfa::One;
+    else if (value < 8)
+      dfa.classes[c] = Dfa::Octal;
+    else if (value < 10)
+      dfa.classes[c] = Dfa::Decimal;
+    else if (value < 16)
+      dfa.classes[c] = (value == 0xB)   ? Dfa::LetterB
+                       : (value == 0xE) ? Dfa::LetterE
+                                        : Dfa::HexLetter;
+  }
+
+  dfa.classes['o'] = dfa.classes['O'] = Dfa::LetterO;
+  dfa.classes['p'] = dfa.classes['P'] = Dfa::LetterP;
+  dfa.classes['x'] = dfa.classes['X'] = Dfa::LetterX;
+  dfa.classes['.'] = Dfa::Dot;
+  dfa.classes['\''] = Dfa::Separator;
+  dfa.classes['+'] = dfa.classes['-'] = Dfa::Sign;
+
+  uint8_t states = 1;
+
+  // "0" and the prefix letter, then `next`
+  auto prefix = [&](uint8_t letter, uint8_t next) {
+    uint8_t zero = states++, marker = states++;
+    dfa.next[zero][Dfa::Zero] = marker;
+    dfa.next[marker][letter] = next;
+    return zero;
+  };
+
+  /*
+   * A float is in a section (integer, fraction, exponent), has seen
+   * digits in it or not and is right after a separator or not, with
+   * one more state for right after the exponent marker.
+   */
+  enum Section { Integer, Fraction, Exponent };
+
+  auto float_grammar = [&](unsigned base, uint8_t exponent_marker) {
+    uint8_t first = states;
+    uint8_t marker = first + 12;
+    states += 13;
+
+    auto state = [first](int section, bool digits, bool separator) {
+      return (uint8_t)(first + (section * 4) + (digits * 2) + separator);
+    };
+
+    for (int section : {Integer, Fraction, Exponent}) {
+      unsigned section_base = (section == Exponent) ? 10 : base;
+
+      for (bool digits : {false, true}) {
+        for (bool separator : {false, true}) {
+          uint8_t from = state(section, digits, separator);
+          dfa.accepting[from] = digits;
+
+          for (uint8_t cls = 0; cls < Dfa::Classes; ++cls) {
+            uint8_t &to = dfa.next[from][cls];
+
+            if (is_digit_class(cls, section_base))
+              to = state(section, true, false);
+            else if (cls == Dfa::Separator && !separator)
+              to = state(section, digits, true);
+            else if (cls == Dfa::Dot && section == Integer && digits)
+              to = state(Fraction, false, false);
+            else if (cls == exponent_marker && section != Exponent && digits)
+              to = marker;
+          }
+        }
+      }
+    }
+
+    for (uint8_t cls = 0; cls < Dfa::Classes; ++cls) {
+      if (is_digit_class(cls, 10))
+        dfa.next[marker][cls] = state(Exponent, true, false);
+    }
+    dfa.next[marker][Dfa::Separator] = state(Exponent, false, true);
+    dfa.next[marker][Dfa::Sign] = state(Exponent, false, false);
+
+    return state(Integer, false, false);
+  };
+
+  // digits and separators after the prefix, at least one of them
+  auto integer_grammar = [&](unsigned base) {
+    uint8_t none = states++, digit = states++, separator = states++;
+
+    for (uint8_t from : {none, digit, separator}) {
+      for (uint8_t cls = 0; cls < Dfa::Classes; ++cls) {
+        if (is_digit_class(cls, base))
+          dfa.next[from][cls] = digit;
+        else if (cls == Dfa::Separator && from != separator)
+          dfa.next[from][cls] = separator;
+      }
+    }
+
+    dfa.accepting[digit] = dfa.accepting[separator] = true;
+    return none;
+  };
+
+  // a decimal starts with a digit, which its integer state can't tell
+  uint8_t dec = float_grammar(10, Dfa::LetterE);
+  uint8_t dec_start = states++;
+  for (uint8_t cls = 0; cls < Dfa::Classes; ++cls) {
+    if (is_digit_class(cls, 10))
+      dfa.next[dec_start][cls] = dfa.next[dec][cls];
+  }
+
+  dfa.start[(size_t)Grammar::Dec] = dec_start;
+  dfa.start[(size_t)Grammar::Hex] =
+      prefix(Dfa::LetterX, float_grammar(16, Dfa::LetterP));
+  dfa.start[(size_t)Grammar::Oct] = prefix(Dfa::LetterO, integer_grammar(8));
+  dfa.start[(size_t)Grammar::Bin] = prefix(Dfa::LetterB, integer_grammar(2));
+
+  return dfa;
+}
+
+constexpr ValidatorDfa validator_dfa = make_validator_dfa();
+
+constexpr bool validate(Grammar grammar, std::string_view str) {
+  const ValidatorDfa &dfa = validator_dfa;
+  uint8_t state = dfa.start[(size_t)grammar];
+
+  for (unsigned char c : str)
+    state = dfa.next[state][dfa.classes[c]];
+
+  return dfa.accepting[state];
+}
+
+constexpr bool validate_dec(std::string_view str) {
+  return validate(Grammar::Dec, str);
+}
+
+constexpr bool validate_hex(std::string_view str) {
+  return validate(Grammar::Hex, str);
+}
+
+constexpr bool validate_oct(std::string_view str) {
+  return validate(Grammar::Oct, str);
+}
+
+constexpr bool validate_bin(std::string_view str) {
+  return validate(Grammar::Bin, str);
+}
+
+/*
+ * Validate `count` literals of one grammar into `valid`, `streams` of
+ * them interleaved: their transitions don't depend on each other, so
+ * the table loads of one hide the latency of the others. The streams
+ * step together for as long as the shortest one lasts, and a finished
+ * stream takes the next literal.
+ */
+template <size_t streams = 4>
+void validate_batch(Grammar grammar, const std::string_view *literals,
+                    size_t count, bool *valid) {
+  const ValidatorDfa &dfa = validator_dfa;
+  const uint8_t start = dfa.start[(size_t)grammar];
+
+  const unsigned char *p[streams], *end[streams];
+  uint8_t state[streams];
+  size_t index[streams];
+
+  size_t next = 0;
+  auto take = [&](size_t i) {
+    index[i] = next;
+    p[i] = (const unsigned char *)literals[next].data();
+    end[i] = p[i] + literals[next].length();
+    state[i] = start;
+    next++;
+  };
+
+  if (count >= streams) {
+    for (size_t i = 0; i < streams; ++i)
+      take(i);
+
+    for (;;) {
+      size_t steps = end[0] - p[0];
+      for (size_t i = 1; i < streams; ++i)
+        steps = std::min<size_t>(steps, end[i] - p[i]);
+
+      for (size_t k = 0; k < steps; ++k) {
+        for (size_t i = 0; i < streams; ++i)
+          state[i] = dfa.next[state[i]][dfa.classes[p[i][k]]];
+      }
+
+      bool exhausted = false;
+      for (size_t i = 0; i < streams; ++i) {
+        p[i] += steps;
+        if (p[i] != end[i])
+          continue;
+
+        valid[index[i]] = dfa.accepting[state[i]];
+        if (next < count) {
+          take(i);
+        } else {
+          end[i] = nullptr;
+          exhausted = true;
+        }
+      }
+
+      if (exhausted)
+        break;
+    }
+
+    // the streams still going, one at a time
+    for (size_t i = 0; i < streams; ++i) {
+      if (!end[i])
+        continue;
+
+      for (; p[i] < end[i]; ++p[i])
+        state[i] = dfa.next[state[i]][dfa.classes[*p[i]]];
+      valid[index[i]] = dfa.accepting[state[i]];
+    }
+  }
+
+  for (; next < count; ++next)
+    valid[next] = validate(grammar, literals[next]);
+}